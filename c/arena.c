@@ -1,73 +1,372 @@
+#define _DEFAULT_SOURCE
+
 #include "arena.h"
 
+#include <pthread.h>
+
+#ifdef ARENA_TRACE
+#include <stdio.h>
+#include <time.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define ARENA_HAVE_MMAP 1
+#endif
+
 Arena_t *arena = {0};
 
-// Create and initialize the arena with a fixed size
-Arena_t* arena_create(size_t initial_size) {
-    if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+_Thread_local Arena_t *arena_thread_arena = NULL;
+
+// Key whose destructor tears down each thread's default arena at thread exit
+static pthread_key_t arena_thread_key;
+static pthread_once_t arena_thread_key_once = PTHREAD_ONCE_INIT;
+
+#ifdef ARENA_HAVE_MMAP
+// System page size, queried once; pthread_once so threads using the arena API don't race on it
+static size_t arena_page = 0;
+static pthread_once_t arena_page_once = PTHREAD_ONCE_INIT;
+
+static void arena_page_init(void) {
+    arena_page = (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static size_t arena_page_size(void) {
+    pthread_once(&arena_page_once, arena_page_init);
+    return arena_page;
+}
+#endif
+
+// Return a block's memory to the system (unmapped if it was reserved, freed otherwise)
+static void arena_free_memory(Arena_t* block) {
+#ifdef ARENA_HAVE_MMAP
+    if (block->limit) {
+        munmap(block->base, (size_t)(block->limit - block->base));
+        return;
+    }
+#endif
+    free(block->base);
+}
+
+// Map `*size` bytes (rounded up to huge pages) on a huge page boundary; NULL if mapping fails
+static uint8_t* arena_map_huge(size_t* size) {
+#ifdef ARENA_HAVE_MMAP
+    if (*size > SIZE_MAX - 2 * ARENA_HUGE_PAGE_SIZE) return NULL;  // Rounding and over-mapping would wrap
+    size_t bytes = align_up(*size, ARENA_HUGE_PAGE_SIZE);
+    void* mem;
+#ifdef MAP_HUGETLB
+    mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+        *size = bytes;
+        return (uint8_t*)mem;
+    }
+#endif
+    // No reserved hugetlb pages: over-map, trim to a huge page boundary and ask for THP
+    size_t span = bytes + ARENA_HUGE_PAGE_SIZE;
+    mem = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return NULL;
+    uint8_t* raw = (uint8_t*)mem;
+    uint8_t* aligned = (uint8_t*)align_up((uintptr_t)raw, ARENA_HUGE_PAGE_SIZE);
+    if (aligned > raw) munmap(raw, (size_t)(aligned - raw));
+    size_t tail = (size_t)(raw + span - (aligned + bytes));
+    if (tail) munmap(aligned + bytes, tail);
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    *size = bytes;
+    return aligned;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+// Commit more of a reserved block so it extends to at least `need`; returns 0 if the reserve can't cover it
+static int arena_commit(Arena_t* block, uint8_t* need) {
+#ifdef ARENA_HAVE_MMAP
+    if (!block->limit || need > block->limit) return 0;
+    size_t committed = (size_t)(block->end - block->base);
+    size_t reserved = (size_t)(block->limit - block->base);
+    size_t want = (size_t)(need - block->base);
+    // Commit geometrically to keep mprotect calls rare; pages only become resident when touched
+    if (want < committed * 2) want = committed * 2;
+    want = align_up(want, arena_page_size());
+    if (want > reserved) want = reserved;
+    if (mprotect(block->end, want - committed, PROT_READ | PROT_WRITE) != 0) return 0;
+    block->end = block->base + want;
+    return 1;
+#else
+    (void)block;
+    (void)need;
+    return 0;
+#endif
+}
+
+// Record how far a rewound block was used and give its released pages back if past the threshold
+static void arena_trim(Arena_t* _arena, Arena_t* block, uint8_t* high) {
+    if (high < block->dirty) high = block->dirty;
+    block->dirty = high;
+#ifdef ARENA_HAVE_MMAP
+    if (_arena->trim_threshold == 0) return;
+    size_t released = (size_t)(high - block->bump);
+    if (released <= _arena->trim_keep || released - _arena->trim_keep < _arena->trim_threshold) return;
+    // Only whole pages inside the block can be released
+    size_t page = arena_page_size();
+    uint8_t* from = (uint8_t*)align_up((uintptr_t)(block->bump + _arena->trim_keep), page);
+    uint8_t* to = (uint8_t*)align_up((uintptr_t)high, page);
+    uint8_t* stop = (uint8_t*)((uintptr_t)block->end & ~(uintptr_t)(page - 1));
+    if (to > stop) to = stop;
+    if (to <= from) return;
+    int advice = MADV_DONTNEED;
+#ifdef MADV_FREE
+    if (_arena->trim_lazy) advice = MADV_FREE;
+#endif
+    if (madvise(from, (size_t)(to - from), advice) == 0) block->dirty = from;
+#endif
+}
+
+// Free a single block's memory and header
+static void arena_free_block(Arena_t* block) {
+    arena_free_memory(block);
+    if (block->markers) free(block->markers);  // Only root has markers
+#ifdef ARENA_TRACE
+    free(block->trace);
+#endif
+    free(block);
+}
+
+// Hand a detached chain of blocks back to the root: cache what fits, free the rest
+static void arena_release_blocks(Arena_t* _arena, Arena_t* n) {
+    while (n) {
+        Arena_t* temp = n->next;
+        size_t cap = (size_t)(n->end - n->base);
+        if (_arena->cached_bytes + cap <= _arena->cache_limit) {
+            // A cached block is fully released: trim it like any rewound block
+            uint8_t* high = n->bump;
+            n->bump = n->base;
+            arena_trim(_arena, n, high);
+            n->next = _arena->free_blocks;
+            _arena->free_blocks = n;
+            _arena->cached_bytes += cap;
+        } else {
+            arena_free_block(n);
+        }
+        n = temp;
+    }
+}
+
+// Take a block of at least `bytes` from the cache, preferring the smallest that holds `want`
+static Arena_t* arena_take_cached_block(Arena_t* _arena, size_t bytes, size_t want) {
+    Arena_t** best = NULL;
+    for (Arena_t** link = &_arena->free_blocks; *link; link = &(*link)->next) {
+        size_t cap = (size_t)((*link)->end - (*link)->base);
+        if (cap < bytes) continue;
+        if (!best) {
+            best = link;
+            continue;
+        }
+        size_t best_cap = (size_t)((*best)->end - (*best)->base);
+        // Smallest block that covers the full growth size, otherwise the largest that fits
+        if (cap >= want ? (best_cap < want || cap < best_cap) : (best_cap < want && cap > best_cap))
+            best = link;
+    }
+    if (!best) return NULL;
+    Arena_t* block = *best;
+    *best = block->next;
+    _arena->cached_bytes -= (size_t)(block->end - block->base);
+    block->bump = block->base;
+    block->next = NULL;
+    return block;
+}
+
+// Run and unlink the finalizers registered after `stop`, newest first; each node is unlinked
+// before it runs, so a finalizer that registers another one can't loop
+static void arena_run_cleanups(Arena_t* _arena, ArenaCleanup_t* stop) {
+    while (_arena->cleanups != stop) {
+        ArenaCleanup_t* node = _arena->cleanups;
+        _arena->cleanups = node->next;
+        node->fn(node->arg);
+    }
+}
+
+// Bytes currently used in the live chain
+static size_t arena_used(const Arena_t* _arena) {
+    return _arena->counters.chain_used + (size_t)(_arena->current->bump - _arena->current->base);
+}
+
+// Fold the current usage into the peak; called wherever usage is about to drop
+static void arena_note_peak(Arena_t* _arena) {
+    size_t used = arena_used(_arena);
+    if (used > _arena->counters.peak) _arena->counters.peak = used;
+}
+
+// Allocate the root header and marker stack around already obtained memory
+static Arena_t* arena_create_root(uint8_t* base, size_t size, uint8_t* limit) {
     Arena_t* _arena = (Arena_t*)malloc(sizeof(Arena_t));
     if (!_arena) return NULL;
-    _arena->base = (uint8_t*)malloc(initial_size);
-    if (!_arena->base) {
-        free(_arena);
-        return NULL;
-    }
+    _arena->base = base;
     _arena->bump = _arena->base;
-    _arena->end = _arena->base + initial_size;
-    _arena->markers = (size_t*)malloc(ARENA_INITIAL_MARKER_CAP * sizeof(size_t));
+    _arena->end = _arena->base + size;
+    _arena->limit = limit;
+    _arena->dirty = _arena->base;
+    _arena->markers = (ArenaMarker_t*)malloc(ARENA_INITIAL_MARKER_CAP * sizeof(ArenaMarker_t));
     if (!_arena->markers) {
-        free(_arena->base);
         free(_arena);
         return NULL;
     }
     _arena->marker_count = 0;
     _arena->marker_cap = ARENA_INITIAL_MARKER_CAP;
     _arena->next = NULL;
+    _arena->current = _arena;
+    _arena->free_blocks = NULL;
+    _arena->cached_bytes = 0;
+    _arena->cache_limit = ARENA_DEFAULT_CACHE_LIMIT;
+    _arena->huge_pages = 0;
+    _arena->trim_threshold = 0;
+    _arena->trim_keep = 0;
+    _arena->trim_lazy = 0;
+    _arena->cleanups = NULL;
+    memset(&_arena->counters, 0, sizeof(_arena->counters));
+#ifdef ARENA_TRACE
+    // Tracing is best effort: without a buffer the arena simply records nothing
+    _arena->trace = (ArenaTrace_t*)malloc(sizeof(ArenaTrace_t));
+    if (_arena->trace) {
+        _arena->trace->next = 0;
+        _arena->trace->count = 0;
+    }
+#endif
+    return _arena;
+}
+
+// Create and initialize the arena with a fixed size
+Arena_t* arena_create(size_t initial_size) {
+    if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+    initial_size = align_up(initial_size, ARENA_ALIGNMENT);
+    uint8_t* base = (uint8_t*)malloc(initial_size);
+    if (!base) return NULL;
+    Arena_t* _arena = arena_create_root(base, initial_size, NULL);
+    if (!_arena) free(base);
     return _arena;
 }
 
+// Create a reserved arena: map the whole range inaccessible and commit the first `initial_size` bytes
+Arena_t* arena_create_reserved(size_t initial_size, size_t reserve_size) {
+#ifdef ARENA_HAVE_MMAP
+    size_t page = arena_page_size();
+    if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+    initial_size = align_up(initial_size, page);
+    reserve_size = align_up(reserve_size, page);
+    if (reserve_size < initial_size) reserve_size = initial_size;
+    void* mem = mmap(NULL, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) return NULL;
+    uint8_t* base = (uint8_t*)mem;
+    if (mprotect(base, initial_size, PROT_READ | PROT_WRITE) != 0) {
+        munmap(base, reserve_size);
+        return NULL;
+    }
+    Arena_t* _arena = arena_create_root(base, initial_size, base + reserve_size);
+    if (!_arena) munmap(base, reserve_size);
+    return _arena;
+#else
+    // No virtual memory control: behave like a regular chained arena
+    (void)reserve_size;
+    return arena_create(initial_size);
+#endif
+}
+
 // Destroy the arena chain and free resources
 void arena_destroy(Arena_t* _arena) {
     if (!_arena) return;
-    Arena_t* cur = _arena;
+    arena_run_cleanups(_arena, NULL);
+    Arena_t* cur = _arena->free_blocks;
+    while (cur) {
+        Arena_t* next = cur->next;
+        arena_free_block(cur);
+        cur = next;
+    }
+    cur = _arena;
     while (cur) {
         Arena_t* next = cur->next;
-        free(cur->base);
-        if (cur->markers) free(cur->markers);  // Only root has markers
-        free(cur);
+        arena_free_block(cur);
         cur = next;
     }
 }
 
-// Allocate memory from the arena (grows via chaining if out of space)
-void* arena_alloc(Arena_t* _arena, size_t bytes) {
-    if (bytes == 0) return NULL;
-    bytes = align_up(bytes, ARENA_ALIGNMENT);
-    Arena_t* last = get_last_block(_arena);
-    if (last->bump + bytes > last->end) {
-        // Grow by chaining a new block
-        size_t prev_size = (size_t)(last->end - last->base);
-        size_t new_size = prev_size * 2;
-        if (new_size < ARENA_DEFAULT_SIZE) new_size = ARENA_DEFAULT_SIZE;
-        if (new_size < bytes) new_size = bytes;
-        Arena_t* new_arena = (Arena_t*)malloc(sizeof(Arena_t));
+// Slow path of allocation: chain a new block (reusing a cached one when possible)
+void* arena_grow(Arena_t* _arena, size_t bytes, size_t align, size_t* padding) {
+    // The padded size below (and the aligned bump) must not wrap around
+    if (bytes > SIZE_MAX - align) return NULL;
+    Arena_t* last = _arena->current;
+    if (last->limit) {
+        // Reserved block: commit more pages in place instead of chaining
+        uint8_t* ptr = (uint8_t*)align_up((uintptr_t)last->bump, align);
+        if (ptr <= last->limit && bytes <= (size_t)(last->limit - ptr) && arena_commit(last, ptr + bytes)) {
+            if (padding) *padding = (size_t)(ptr - last->bump);
+            _arena->counters.growths++;
+            _arena->counters.padding += (size_t)(ptr - last->bump);
+            last->bump = ptr + bytes;
+#ifdef ARENA_TRACE
+            arena_trace_event(_arena, ARENA_TRACE_GROW, NULL, (size_t)(last->end - last->base));
+            arena_trace_event(_arena, ARENA_TRACE_ALLOC, NULL, bytes);
+#endif
+            return ptr;
+        }
+    }
+    // Blocks are only guaranteed ARENA_ALIGNMENT, so reserve room to pad up to `align`
+    size_t needed = bytes + (align > ARENA_ALIGNMENT ? align - ARENA_ALIGNMENT : 0);
+    size_t prev_size = (size_t)(last->end - last->base);
+    size_t new_size = prev_size * 2;
+    if (new_size < ARENA_DEFAULT_SIZE) new_size = ARENA_DEFAULT_SIZE;
+    if (new_size < needed) new_size = needed;
+    new_size = align_up(new_size, ARENA_ALIGNMENT);
+    Arena_t* new_arena = arena_take_cached_block(_arena, needed, new_size);
+    if (!new_arena) {
+        new_arena = (Arena_t*)malloc(sizeof(Arena_t));
         if (!new_arena) return NULL;
-        new_arena->base = (uint8_t*)malloc(new_size);
-        if (!new_arena->base) {
+        uint8_t* mem = _arena->huge_pages ? arena_map_huge(&new_size) : NULL;
+        new_arena->limit = mem ? mem + new_size : NULL;
+        if (!mem) mem = (uint8_t*)malloc(new_size);
+        if (!mem) {
             free(new_arena);
             return NULL;
         }
+        new_arena->base = mem;
         new_arena->bump = new_arena->base;
         new_arena->end = new_arena->base + new_size;
+        new_arena->dirty = new_arena->base;
         new_arena->markers = NULL;  // Non-root has no markers
         new_arena->marker_count = 0;
         new_arena->marker_cap = 0;
         new_arena->next = NULL;
-        last->next = new_arena;
-        last = new_arena;
+        new_arena->current = NULL;  // Only the root tracks the current block
+        new_arena->free_blocks = NULL;
+        new_arena->cached_bytes = 0;
+        new_arena->cache_limit = 0;
+        new_arena->huge_pages = 0;
+        new_arena->trim_threshold = 0;
+        new_arena->trim_keep = 0;
+        new_arena->trim_lazy = 0;
+        new_arena->cleanups = NULL;
+        memset(&new_arena->counters, 0, sizeof(new_arena->counters));
+#ifdef ARENA_TRACE
+        new_arena->trace = NULL;
+#endif
+        _arena->counters.mallocs++;
     }
-    void* ptr = last->bump;
-    last->bump += bytes;
+    _arena->counters.growths++;
+    _arena->counters.tail_waste += (size_t)(last->end - last->bump);
+    _arena->counters.chain_used += (size_t)(last->bump - last->base);
+    last->next = new_arena;
+    _arena->current = new_arena;
+    uint8_t* ptr = (uint8_t*)align_up((uintptr_t)new_arena->bump, align);
+    if (padding) *padding = (size_t)(ptr - new_arena->bump);
+    _arena->counters.padding += (size_t)(ptr - new_arena->bump);
+    new_arena->bump = ptr + bytes;
+#ifdef ARENA_TRACE
+    arena_trace_event(_arena, ARENA_TRACE_GROW, NULL, (size_t)(new_arena->end - new_arena->base));
+    arena_trace_event(_arena, ARENA_TRACE_ALLOC, NULL, bytes);
+#endif
     return ptr;
 }
 
@@ -89,30 +388,20 @@ void* arena_realloc(Arena_t* _arena, void* ptr, size_t old_size, size_t new_size
         // Like alloc
         return arena_alloc(_arena, new_size);
     }
-    old_size = align_up(old_size, ARENA_ALIGNMENT);
-    new_size = align_up(new_size, ARENA_ALIGNMENT);
-
-    // Find the block containing ptr
-    Arena_t* cur = _arena;
-    while (cur) {
-        if ((uint8_t*)ptr >= cur->base && (uint8_t*)ptr < cur->end) {
-            // Check if ptr is the last allocation in this block
-            if ((uint8_t*)ptr + old_size == cur->bump) {
-                // It's the last one; try to resize in place
-                size_t extra_needed = new_size > old_size ? new_size - old_size : 0;
-                if (cur->bump + extra_needed <= cur->end) {
-                    // Enough space: adjust bump
-                    cur->bump = (uint8_t*)ptr + new_size;
-                    return ptr;
-                } else if (new_size < old_size) {
-                    // Shrinking: adjust bump back
-                    cur->bump = (uint8_t*)ptr + new_size;
-                    return ptr;
-                }
-            }
-            break;  // Not last or can't resize: fall to copy
+    // Only the most recent allocation (at the bump of the current block) can resize in place
+    Arena_t* cur = _arena->current;
+    if ((uint8_t*)ptr + old_size == cur->bump) {
+        size_t extra_needed = new_size > old_size ? new_size - old_size : 0;
+        if (cur->bump + extra_needed <= cur->end || arena_commit(cur, (uint8_t*)ptr + new_size)) {
+            // Enough space (or shrinking, or a reserved block committed more): adjust bump
+            if (new_size < old_size) arena_note_peak(_arena);
+            cur->bump = (uint8_t*)ptr + new_size;
+#ifdef ARENA_TRACE
+            if (new_size > old_size) arena_trace_event(_arena, ARENA_TRACE_ALLOC, NULL, new_size - old_size);
+            else if (new_size < old_size) arena_trace_event(_arena, ARENA_TRACE_FREE, NULL, old_size - new_size);
+#endif
+            return ptr;
         }
-        cur = cur->next;
     }
 
     // Can't resize in place: allocate new and copy
@@ -125,71 +414,247 @@ void* arena_realloc(Arena_t* _arena, void* ptr, size_t old_size, size_t new_size
 }
 
 
-// Push a marker (saves current global position); operates on root
+// Register a finalizer; the node is allocated in the arena so it goes away with the scope it guards
+int arena_add_cleanup(Arena_t* _arena, void (*fn)(void* arg), void* arg) {
+    ArenaCleanup_t* node = (ArenaCleanup_t*)arena_alloc(_arena, sizeof(ArenaCleanup_t));
+    if (!node) return 0;
+    node->next = _arena->cleanups;
+    node->fn = fn;
+    node->arg = arg;
+    _arena->cleanups = node;
+    return 1;
+}
+
+// Push a marker (saves the current block and its bump pointer); operates on root
 void arena_push_marker(Arena_t* _arena) {
+    arena_push_marker_tagged(_arena, NULL);
+}
+
+// Push a marker named `tag` in traces
+void arena_push_marker_tagged(Arena_t* _arena, const char* tag) {
     if (_arena->marker_count == _arena->marker_cap) {
         size_t new_cap = _arena->marker_cap * 2;
-        size_t* new_markers = (size_t*)realloc(_arena->markers, new_cap * sizeof(size_t));
+        ArenaMarker_t* new_markers = (ArenaMarker_t*)realloc(_arena->markers, new_cap * sizeof(ArenaMarker_t));
         if (!new_markers) return; // Fail silently; marker not pushed
         _arena->markers = new_markers;
         _arena->marker_cap = new_cap;
     }
-    size_t pos = get_current_position(_arena);
-    _arena->markers[_arena->marker_count++] = pos;
+    ArenaMarker_t* m = &_arena->markers[_arena->marker_count++];
+    m->block = _arena->current;
+    m->bump = _arena->current->bump;
+    m->cleanups = _arena->cleanups;
+    m->chain_used = _arena->counters.chain_used;
+    m->padding = _arena->counters.padding;
+    m->tail_waste = _arena->counters.tail_waste;
+#ifdef ARENA_TRACE
+    m->tag = tag;
+    arena_trace_event(_arena, ARENA_TRACE_PUSH, tag, 0);
+#else
+    (void)tag;
+#endif
 }
 
 
-// Pop a marker (resets to last saved global position); frees later blocks if needed
+// Pop a marker (rewinds to the saved block and bump pointer); releases later blocks
 void arena_pop_marker(Arena_t* _arena) {
     if (_arena->marker_count == 0) return;
-    size_t g = _arena->markers[--_arena->marker_count];
-    size_t c = 0;
-    Arena_t* cur = _arena;
-    Arena_t* prev = NULL;
-    while (cur) {
-        size_t block_cap = (size_t)(cur->end - cur->base);
-        if (g <= c + block_cap) {
-            cur->bump = cur->base + (g - c);
-            // Free all subsequent blocks
-            Arena_t* n = cur->next;
-            cur->next = NULL;
-            while (n) {
-                Arena_t* temp = n->next;
-                free(n->base);
-                if (n->markers) free(n->markers);  // Should be NULL for non-root
-                free(n);
-                n = temp;
-            }
-            break;
-        } else {
-            c += block_cap;
-            prev = cur;
-            cur = cur->next;
-        }
-    }
+    ArenaMarker_t m = _arena->markers[--_arena->marker_count];
+    // Finalizers run before the memory they may touch is rewound
+    arena_run_cleanups(_arena, m.cleanups);
+    arena_note_peak(_arena);
+    _arena->counters.chain_used = m.chain_used;
+    _arena->counters.padding = m.padding;
+    _arena->counters.tail_waste = m.tail_waste;
+    Arena_t* cur = m.block;
+    uint8_t* high = cur->bump;
+    cur->bump = m.bump;
+    _arena->current = cur;
+    arena_trim(_arena, cur, high);
+    // Release all subsequent blocks to the cache
+    Arena_t* n = cur->next;
+    cur->next = NULL;
+    arena_release_blocks(_arena, n);
+#ifdef ARENA_TRACE
+    arena_trace_event(_arena, ARENA_TRACE_POP, m.tag, 0);
+#endif
 }
 
-// Reset the entire arena chain (clears markers, resets to root base, frees chains)
+// Reset the entire arena chain (clears markers, resets to root base, releases chains)
 void arena_reset(Arena_t* _arena) {
+    arena_run_cleanups(_arena, NULL);
+    arena_note_peak(_arena);
+#ifdef ARENA_TRACE
+    // Close the scopes of the markers dropped along with everything else, innermost first
+    while (_arena->marker_count > 0) {
+        arena_trace_event(_arena, ARENA_TRACE_POP, _arena->markers[--_arena->marker_count].tag, 0);
+    }
+#endif
+    _arena->counters.chain_used = 0;
+    _arena->counters.padding = 0;
+    _arena->counters.tail_waste = 0;
     _arena->marker_count = 0;
-    // Free all chained blocks
+    // Release all chained blocks to the cache
     Arena_t* n = _arena->next;
     _arena->next = NULL;
-    while (n) {
-        Arena_t* temp = n->next;
-        if (n->base) free(n->base);
-        if (n->markers) free(n->markers);
-        free(n);
-        n = temp;
-    }
+    arena_release_blocks(_arena, n);
+    uint8_t* high = _arena->bump;
     _arena->bump = _arena->base;
+    _arena->current = _arena;
+    arena_trim(_arena, _arena, high);
+#ifdef ARENA_TRACE
+    arena_trace_event(_arena, ARENA_TRACE_RESET, NULL, 0);
+#endif
+}
+
+// Cap the bytes kept in the released-block cache; frees cached blocks beyond the new cap
+void arena_set_cache_limit(Arena_t* _arena, size_t bytes) {
+    _arena->cache_limit = bytes;
+    Arena_t* n = _arena->free_blocks;
+    _arena->free_blocks = NULL;
+    _arena->cached_bytes = 0;
+    arena_release_blocks(_arena, n);
+}
+
+// Configure page trimming on pop_marker/reset
+void arena_set_trim_policy(Arena_t* _arena, size_t threshold, size_t keep, int lazy) {
+    _arena->trim_threshold = threshold;
+    _arena->trim_keep = keep;
+    _arena->trim_lazy = lazy;
+}
+
+// Back blocks chained from now on with huge pages
+void arena_set_huge_pages(Arena_t* _arena, int enable) {
+    _arena->huge_pages = enable;
+#if defined(ARENA_HAVE_MMAP) && defined(MADV_HUGEPAGE)
+    if (enable && _arena->limit) {
+        // Advise the huge-page-aligned interior of the root mapping
+        uint8_t* start = (uint8_t*)align_up((uintptr_t)_arena->base, ARENA_HUGE_PAGE_SIZE);
+        uint8_t* stop = (uint8_t*)((uintptr_t)_arena->limit & ~(uintptr_t)(ARENA_HUGE_PAGE_SIZE - 1));
+        if (stop > start) madvise(start, (size_t)(stop - start), MADV_HUGEPAGE);
+    }
+#endif
+}
+
+// Thread-exit hook: destroy the exiting thread's default arena
+static void arena_thread_exit(void* _arena) {
+    arena_thread_arena = NULL;
+    arena_destroy((Arena_t*)_arena);
+}
+
+static void arena_thread_key_init(void) {
+    pthread_key_create(&arena_thread_key, arena_thread_exit);
+}
+
+// Slow path of arena_thread_default: create this thread's arena and register it for thread exit
+Arena_t* arena_thread_default_create(void) {
+    pthread_once(&arena_thread_key_once, arena_thread_key_init);
+    Arena_t* _arena = arena_create(ARENA_DEFAULT_SIZE);
+    if (!_arena) return NULL;
+    if (pthread_setspecific(arena_thread_key, _arena) != 0) {
+        arena_destroy(_arena);
+        return NULL;
+    }
+    arena_thread_arena = _arena;
+    return _arena;
+}
+
+ArenaStats_t arena_stats(Arena_t* _arena) {
+    arena_note_peak(_arena);
+    ArenaStats_t s;
+    s.bytes_used = arena_used(_arena);
+    s.bytes_requested = s.bytes_used - _arena->counters.padding;
+    s.bytes_committed = _arena->cached_bytes;
+    s.block_count = 0;
+    for (const Arena_t* cur = _arena; cur; cur = cur->next) {
+        s.bytes_committed += (size_t)(cur->end - cur->base);
+        s.block_count++;
+    }
+    s.padding_waste = _arena->counters.padding;
+    s.tail_waste = _arena->counters.tail_waste;
+    s.peak_used = _arena->counters.peak;
+    s.growth_events = _arena->counters.growths;
+    s.system_allocs = _arena->counters.mallocs;
+    s.marker_depth = _arena->marker_count;
+    return s;
+}
+
+#ifdef ARENA_TRACE
+// Overwrite the oldest event once the ring is full
+void arena_trace_event(Arena_t* _arena, uint8_t type, const char* tag, size_t bytes) {
+    ArenaTrace_t* t = _arena->trace;
+    if (!t) return;
+    ArenaTraceEvent_t* e = &t->events[t->next];
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    e->ns = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    e->tag = tag;
+    e->bytes = bytes;
+    e->used = arena_used(_arena);
+    e->type = type;
+    t->next = (t->next + 1) % ARENA_TRACE_CAPACITY;
+    if (t->count < ARENA_TRACE_CAPACITY) t->count++;
+}
+
+// Write a string as a JSON string literal
+static void arena_write_json_string(FILE* f, const char* str) {
+    fputc('"', f);
+    for (const unsigned char* c = (const unsigned char*)str; *c; c++) {
+        if (*c == '"' || *c == '\\') fprintf(f, "\\%c", *c);
+        else if (*c < 0x20) fprintf(f, "\\u%04x", *c);
+        else fputc(*c, f);
+    }
+    fputc('"', f);
+}
+#endif
+
+// Events are written oldest first; once the ring has wrapped, the oldest scopes may have lost
+// their begin event (the viewer then shows them open from the start of the trace)
+int arena_dump_trace(const Arena_t* _arena, const char* path) {
+#ifdef ARENA_TRACE
+    const ArenaTrace_t* t = _arena->trace;
+    if (!t || !path) return 0;
+    FILE* f = fopen(path, "w");
+    if (!f) return 0;
+    fputs("{\"traceEvents\":[", f);
+    size_t first = (t->next + ARENA_TRACE_CAPACITY - t->count) % ARENA_TRACE_CAPACITY;
+    for (size_t i = 0; i < t->count; i++) {
+        const ArenaTraceEvent_t* e = &t->events[(first + i) % ARENA_TRACE_CAPACITY];
+        fputs(i ? ",\n" : "\n", f);
+        switch (e->type) {
+            case ARENA_TRACE_ALLOC:
+            case ARENA_TRACE_FREE:
+                fprintf(f, "{\"name\":\"used\",\"ph\":\"C\",\"args\":{\"bytes\":%zu}", e->used);
+                break;
+            case ARENA_TRACE_GROW:
+                fprintf(f, "{\"name\":\"grow\",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"block\":%zu,\"used\":%zu}",
+                        e->bytes, e->used);
+                break;
+            case ARENA_TRACE_PUSH:
+            case ARENA_TRACE_POP:
+                fputs("{\"name\":", f);
+                arena_write_json_string(f, e->tag ? e->tag : "marker");
+                fprintf(f, ",\"ph\":\"%s\",\"args\":{\"used\":%zu}", e->type == ARENA_TRACE_PUSH ? "B" : "E", e->used);
+                break;
+            default:
+                fputs("{\"name\":\"reset\",\"ph\":\"i\",\"s\":\"t\"", f);
+                break;
+        }
+        fprintf(f, ",\"pid\":1,\"tid\":1,\"ts\":%.3f}", (double)e->ns / 1000.0);
+    }
+    fputs("\n]}\n", f);
+    return fclose(f) == 0;
+#else
+    (void)_arena;
+    (void)path;
+    return 0;
+#endif
 }
 
 // Duplicate a string into the arena
 char* arena_strdup(Arena_t* _arena, const char* str) {
     if (!str) return NULL;
     size_t len = strlen(str) + 1;
-    char* dup = (char*)arena_alloc(_arena, len);
+    char* dup = (char*)arena_alloc_packed(_arena, len);
     if (dup) memcpy(dup, str, len);
     return dup;
 }
@@ -10,62 +10,245 @@
 // Default initial capacity for marker stack
 #define ARENA_INITIAL_MARKER_CAP 16
 
-// Alignment boundary (e.g., 8 bytes for 64-bit)
+// Alignment boundary (e.g., 8 bytes for 64-bit); block ends are kept on this boundary
 #define ARENA_ALIGNMENT 8
 
+// Default cap on bytes kept in the released-block cache for reuse
+#define ARENA_DEFAULT_CACHE_LIMIT (16 * ARENA_DEFAULT_SIZE)
+
+// Huge page size used to align and round blocks when huge pages are enabled
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Define ARENA_TRACE (in every translation unit) to record allocation events per arena into a ring
+// buffer of ARENA_TRACE_CAPACITY entries, exported with arena_dump_trace()
+#ifndef ARENA_TRACE_CAPACITY
+#define ARENA_TRACE_CAPACITY 8192
+#endif
+
+// Branch hints for the allocation fast path
+#if defined(__GNUC__) || defined(__clang__)
+#define ARENA_LIKELY(x) __builtin_expect(!!(x), 1)
+#define ARENA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define ARENA_LIKELY(x) (x)
+#define ARENA_UNLIKELY(x) (x)
+#endif
+
 #ifndef ARENA_H
 #define ARENA_H
 
+// Finalizer registered with arena_add_cleanup; the nodes live in the arena itself
+typedef struct ArenaCleanup_t {
+  struct ArenaCleanup_t *next; // Registered before this one
+  void (*fn)(void *arg);       // Finalizer
+  void *arg;                   // Its argument
+} ArenaCleanup_t;
+
+// Saved allocation position: the block that was current and its bump pointer
+typedef struct ArenaMarker_t {
+  struct Arena_t *block; // Block being bumped when the marker was pushed
+  uint8_t *bump;         // Bump pointer of that block at push time
+  ArenaCleanup_t *cleanups; // Head of the cleanup list at push time
+  size_t chain_used;     // Bytes used in the blocks before `block` at push time
+  size_t padding;        // Padding counter at push time
+  size_t tail_waste;     // Tail waste counter at push time
+#ifdef ARENA_TRACE
+  const char *tag;       // Scope name given to arena_push_marker_tagged
+#endif
+} ArenaMarker_t;
+
+// Running counters behind arena_stats(). Requested bytes are derived (used minus padding), so the
+// allocation fast path only touches `padding`, and only when it actually skips bytes
+typedef struct ArenaCounters_t {
+  size_t padding;    // Alignment padding skipped by live allocations
+  size_t tail_waste; // Unused ends of live blocks left behind by growth
+  size_t chain_used; // Bytes used in the blocks before `current`
+  size_t peak;       // Highest usage seen so far
+  size_t growths;    // Slow-path growth events
+  size_t mallocs;    // Blocks obtained from the system
+} ArenaCounters_t;
+
+// Snapshot of an arena's allocation statistics. Byte counts describe the live allocations (what
+// pop_marker/reset would give back); peak and event counts run from creation.
+typedef struct ArenaStats_t {
+  size_t bytes_requested; // Bytes asked for by live allocations
+  size_t bytes_used;      // Bytes consumed in the live chain: requested plus padding
+  size_t bytes_committed; // Block memory held: the live chain plus cached blocks
+  size_t padding_waste;   // Bytes skipped to align live allocations
+  size_t tail_waste;      // Bytes left unused at the end of live blocks that growth moved past
+  size_t block_count;     // Blocks in the live chain
+  size_t peak_used;       // Highest bytes_used reached
+  size_t growth_events;   // Allocations that took the slow path to a new or further-committed block
+  size_t system_allocs;   // Blocks obtained from the system instead of the block cache
+  size_t marker_depth;    // Markers currently pushed
+} ArenaStats_t;
+
+#ifdef ARENA_TRACE
+enum { ARENA_TRACE_ALLOC, ARENA_TRACE_FREE, ARENA_TRACE_GROW, ARENA_TRACE_PUSH, ARENA_TRACE_POP, ARENA_TRACE_RESET };
+
+// One recorded event
+typedef struct ArenaTraceEvent_t {
+  uint64_t ns;     // Monotonic timestamp
+  const char *tag; // Scope name (push/pop)
+  size_t bytes;    // Allocation size, or new block size for growth
+  size_t used;     // Arena usage after the event
+  uint8_t type;    // ARENA_TRACE_*
+} ArenaTraceEvent_t;
+
+// Ring buffer of the most recent events
+typedef struct ArenaTrace_t {
+  ArenaTraceEvent_t events[ARENA_TRACE_CAPACITY];
+  size_t next;  // Slot the next event goes to
+  size_t count; // Events recorded, saturating at ARENA_TRACE_CAPACITY
+} ArenaTrace_t;
+#endif
+
 typedef struct Arena_t {
   uint8_t *base;       // Start of the memory block
   uint8_t *bump;       // Current allocation pointer
-  uint8_t *end;        // End of the memory block
-  size_t *markers;     // Dynamic array for markers (offsets from base)
+  uint8_t *end;        // End of the memory block (committed part for reserved blocks)
+  uint8_t *limit;      // End of the mapped address range; NULL for malloc'd blocks
+  uint8_t *dirty;      // High-water mark of pages that may still be resident
+  ArenaMarker_t *markers; // Dynamic array of saved positions
   size_t marker_count; // Number of active markers
   size_t marker_cap;   // Capacity of markers array
   struct Arena_t *next;  // For chaining if resizable (optional)
+  struct Arena_t *current; // Block currently being bumped (root only)
+  struct Arena_t *free_blocks; // Released blocks kept for reuse (root only)
+  size_t cached_bytes; // Capacity held in free_blocks
+  size_t cache_limit;  // Max capacity kept in free_blocks
+  int huge_pages;      // Back new blocks with huge pages (root only)
+  size_t trim_threshold; // Trim once this many released bytes sit above bump + trim_keep; 0 = off (root only)
+  size_t trim_keep;    // Bytes above the bump left resident by a trim (root only)
+  int trim_lazy;       // Trim with MADV_FREE instead of MADV_DONTNEED (root only)
+  ArenaCleanup_t *cleanups; // Registered finalizers, newest first (root only)
+  ArenaCounters_t counters; // Statistics (root only)
+#ifdef ARENA_TRACE
+  ArenaTrace_t *trace; // Event ring buffer; NULL if it couldn't be allocated (root only)
+#endif
 } Arena_t;
 
 
 extern Arena_t *arena;
 
+// This thread's default arena (NULL until first requested); use arena_thread_default()
+extern _Thread_local Arena_t *arena_thread_arena;
+
 // Utility to align upwards
 static inline size_t align_up(size_t n, size_t align) {
   return (n + align - 1) & ~(align - 1);
 }
 
-// Helper to get the last block in the chain
-static Arena_t* get_last_block(Arena_t* arena) {
-    Arena_t* cur = arena;
-    while (cur->next) {
-        cur = cur->next;
+Arena_t *arena_create(size_t initial_size);
+
+// Create a single contiguous arena: reserve `reserve_size` bytes of address space up front and
+// commit pages on demand as the bump advances, so growth never chains (until the reserve runs out)
+Arena_t *arena_create_reserved(size_t initial_size, size_t reserve_size);
+void arena_destroy(Arena_t *arena);
+
+// Slow path of allocation: chain a new block that fits `bytes` at `align` and bump it
+void* arena_grow(Arena_t* arena, size_t bytes, size_t align, size_t* padding);
+
+#ifdef ARENA_TRACE
+// Record an event (out of line, so tracing adds only a call to the fast path)
+void arena_trace_event(Arena_t* arena, uint8_t type, const char* tag, size_t bytes);
+#endif
+
+// Allocate memory from the arena: align and bump the current block, chain a new one only when it is full
+static inline void* arena_alloc(Arena_t* _arena, size_t bytes) {
+    if (ARENA_UNLIKELY(bytes == 0)) return NULL;
+    Arena_t* last = _arena->current;
+    // Block ends are ARENA_ALIGNMENT-aligned, so the aligned bump never passes end
+    uint8_t* ptr = (uint8_t*)align_up((uintptr_t)last->bump, ARENA_ALIGNMENT);
+    if (ARENA_LIKELY(bytes <= (size_t)(last->end - ptr))) {
+        if (ARENA_UNLIKELY(ptr != last->bump)) _arena->counters.padding += (size_t)(ptr - last->bump);
+        last->bump = ptr + bytes;
+#ifdef ARENA_TRACE
+        arena_trace_event(_arena, ARENA_TRACE_ALLOC, NULL, bytes);
+#endif
+        return ptr;
     }
-    return cur;
+    return arena_grow(_arena, bytes, ARENA_ALIGNMENT, NULL);
 }
 
-// Helper to compute current global position (total allocated bytes)
-static size_t get_current_position(Arena_t* arena) {
-    size_t pos = 0;
-    Arena_t* cur = arena;
-    while (cur->next) {
-        pos += (size_t)(cur->end - cur->base);
-        cur = cur->next;
+// Allocate memory aligned to `align` (any power of two); padding (if non-NULL) gets the bytes skipped
+static inline void* arena_alloc_aligned(Arena_t* _arena, size_t bytes, size_t align, size_t* padding) {
+    if (ARENA_UNLIKELY(bytes == 0 || align == 0 || (align & (align - 1)) != 0)) return NULL;
+    Arena_t* last = _arena->current;
+    uintptr_t ptr = (uintptr_t)align_up((uintptr_t)last->bump, align);
+    if (ARENA_LIKELY(ptr <= (uintptr_t)last->end && bytes <= (uintptr_t)last->end - ptr)) {
+        if (padding) *padding = (size_t)(ptr - (uintptr_t)last->bump);
+        _arena->counters.padding += (size_t)(ptr - (uintptr_t)last->bump);
+        last->bump = (uint8_t*)ptr + bytes;
+#ifdef ARENA_TRACE
+        arena_trace_event(_arena, ARENA_TRACE_ALLOC, NULL, bytes);
+#endif
+        return (void*)ptr;
     }
-    pos += (size_t)(cur->bump - cur->base);
-    return pos;
+    return arena_grow(_arena, bytes, align, padding);
 }
 
-Arena_t *arena_create(size_t initial_size);
-void arena_destroy(Arena_t *arena);
+// Allocate unaligned bytes packed right after the previous allocation (strings, byte buffers)
+static inline void* arena_alloc_packed(Arena_t* _arena, size_t bytes) {
+    if (ARENA_UNLIKELY(bytes == 0)) return NULL;
+    Arena_t* last = _arena->current;
+    if (ARENA_LIKELY(bytes <= (size_t)(last->end - last->bump))) {
+        void* ptr = last->bump;
+        last->bump += bytes;
+#ifdef ARENA_TRACE
+        arena_trace_event(_arena, ARENA_TRACE_ALLOC, NULL, bytes);
+#endif
+        return ptr;
+    }
+    return arena_grow(_arena, bytes, 1, NULL);
+}
 
-void* arena_alloc(Arena_t* arena, size_t bytes);
 void* arena_calloc(Arena_t* arena, size_t num, size_t size);
 void* arena_realloc(Arena_t* arena, void* ptr, size_t old_size, size_t new_size);
 
+// Run fn(arg) when the enclosing marker is popped, on reset, or when the arena is destroyed,
+// in reverse order of registration; 0 if the arena is out of memory
+int arena_add_cleanup(Arena_t *arena, void (*fn)(void *arg), void *arg);
+
 void arena_push_marker(Arena_t *arena);
+
+// Push a marker naming its scope `tag` in traces (the string must outlive the arena);
+// the same as arena_push_marker when ARENA_TRACE is off
+void arena_push_marker_tagged(Arena_t *arena, const char *tag);
 void arena_pop_marker(Arena_t *arena);
 void arena_reset(Arena_t *arena);
 
+// Cap the bytes kept in the released-block cache (0 disables it); trims the cache immediately
+void arena_set_cache_limit(Arena_t *arena, size_t bytes);
+
+// Return the pages of released memory to the OS on pop_marker/reset once more than `threshold`
+// bytes sit above the bump plus `keep`; `keep` bytes stay resident so oscillating workloads
+// don't fault the same pages back in. `lazy` uses MADV_FREE where available. 0 disables trimming
+void arena_set_trim_policy(Arena_t *arena, size_t threshold, size_t keep, int lazy);
+
+// Back blocks chained from now on with 2 MB huge pages (MAP_HUGETLB, else MADV_HUGEPAGE,
+// else plain malloc); a reserved arena also gets its reservation advised
+void arena_set_huge_pages(Arena_t *arena, int enable);
+
 char* arena_strdup(Arena_t* arena, const char* str);
 
+// Allocation statistics; always on, at the cost of one rarely taken branch in the fast path
+ArenaStats_t arena_stats(Arena_t *arena);
+
+// Write the recorded events to `path` as Chrome trace-event JSON (chrome://tracing, Perfetto):
+// marker scopes as slices, usage as a counter, growth and resets as instants.
+// 0 if ARENA_TRACE is off or the file can't be written
+int arena_dump_trace(const Arena_t *arena, const char *path);
+
+// Slow path of arena_thread_default: create this thread's arena and register it for thread exit
+Arena_t* arena_thread_default_create(void);
+
+// Per-thread default arena: created on first use in each thread, destroyed when the thread exits;
+// NULL only if creation fails
+static inline Arena_t* arena_thread_default(void) {
+    Arena_t* _arena = arena_thread_arena;
+    if (ARENA_LIKELY(_arena != NULL)) return _arena;
+    return arena_thread_default_create();
+}
+
 #endif // ARENA_H
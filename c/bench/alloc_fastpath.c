@@ -0,0 +1,47 @@
+// Per-call cost of arena_alloc for small fixed-size nodes.
+//
+// Build: gcc -O2 c/bench/alloc_fastpath.c c/arena.c -o alloc_fastpath
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../arena.h"
+
+#include <stdio.h>
+#include <time.h>
+
+// Allocations per reset; keeps every allocation inside the root block
+#define BATCH 4096
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double run(Arena_t* a, size_t size, size_t rounds) {
+    uintptr_t sink = 0;
+    double start = now_ns();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            sink += (uintptr_t)arena_alloc(a, size);
+        }
+        arena_reset(a);
+    }
+    double stop = now_ns();
+    if (sink == 1) puts("");  // Keep the allocations observable
+    return (stop - start) / (double)(rounds * BATCH);
+}
+
+int main(void) {
+    Arena_t* a = arena_create(BATCH * 128);
+    if (!a) return EXIT_FAILURE;
+    const size_t sizes[] = {8, 16, 24, 64, 128};
+    const size_t rounds = 20000;
+
+    run(a, 16, rounds / 10);  // Warm up
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        printf("arena_alloc(%3zu): %6.3f ns/op\n", sizes[i], run(a, sizes[i], rounds));
+    }
+    arena_destroy(a);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,362 @@
+// Whole-workload benchmarks on Arena_t: building and checking a compiler-style AST under nested
+// markers, tokenizing a log with arena_strdup, and a request loop that pushes and pops a marker
+// per request. Reports throughput, peak RSS growth and per-unit latency percentiles. The
+// workloads and random streams match cpp/bench/macro.cpp, whose output lines up with this one.
+//
+// Build: gcc -O2 c/bench/macro.c c/arena.c -o macro -pthread
+// Usage: ./macro [log_megabytes]   (default 32, at least 1)
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../arena.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+
+// Keeps results observable so the measured work isn't optimized away
+static uintptr_t sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// xorshift64*: the same stream as cpp/bench/macro.cpp for a given seed
+static uint64_t rng_state;
+
+static uint64_t next_rand(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+// Uniform in [lo, hi]
+static size_t rand_range(size_t lo, size_t hi) {
+    return lo + (size_t)(next_rand() % (hi - lo + 1));
+}
+
+// Current or peak resident set size in KB from /proc/self/status (`field` is "VmRSS:" or
+// "VmHWM:"); falls back to getrusage's process-wide peak where /proc is unavailable
+static long rss_kb(const char* field) {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f) {
+        char line[256];
+        size_t len = strlen(field);
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, field, len) == 0) {
+                fclose(f);
+                return strtol(line + len, NULL, 10);
+            }
+        }
+        fclose(f);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Reset the kernel's peak RSS to the current RSS (Linux 4.0+) so each run reports its own peak
+static void reset_peak_rss(void) {
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return;
+    fputs("5", f);
+    fclose(f);
+}
+
+// Wall time of each unit of work (function, log batch, request)
+typedef struct Latencies {
+    double *ns;
+    size_t count;
+    size_t cap;
+} Latencies;
+
+static void latency_add(Latencies* lat, double start) {
+    if (lat->count == lat->cap) {
+        lat->cap = lat->cap ? lat->cap * 2 : 1024;
+        lat->ns = (double*)realloc(lat->ns, lat->cap * sizeof(double));
+        if (!lat->ns) exit(EXIT_FAILURE);
+    }
+    lat->ns[lat->count++] = now_ns() - start;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Latencies must be sorted
+// 0 when nothing was recorded
+static double percentile(const Latencies* lat, double p) {
+    if (lat->count == 0) return 0;
+    return lat->ns[(size_t)(p / 100.0 * (double)(lat->count - 1))];
+}
+
+static void report(const char* workload, double units, const char* unit, double secs, long rss_kb_growth,
+                   Latencies* lat) {
+    qsort(lat->ns, lat->count, sizeof(double), compare_double);
+    printf("%-9s %-7s %10.2f %-8s %8.1f MB %9.2f %9.2f %9.2f %9.2f\n", workload, "arena_t",
+           units / secs / 1e6, unit, (double)rss_kb_growth / 1024.0, percentile(lat, 50) / 1e3,
+           percentile(lat, 99) / 1e3, percentile(lat, 99.9) / 1e3, percentile(lat, 100) / 1e3);
+    free(lat->ns);
+}
+
+// AST workload: modules of functions whose statements are random expression trees. Each function
+// is checked in a scratch scope with a nested scope per statement; the module's trees stay live
+// until a final pass over the whole module
+
+#define AST_MODULES 40
+#define AST_FUNCTIONS 200
+#define AST_STATEMENTS 8
+#define AST_MAX_DEPTH 7
+
+enum { NODE_NUMBER, NODE_IDENT, NODE_BINARY };
+
+typedef struct Node {
+    int kind;
+    int value;
+    const char* name;
+    struct Node* left;
+    struct Node* right;
+} Node;
+
+// Scratch symbol-table entry made while checking
+typedef struct Symbol {
+    const char* name;
+    struct Symbol* next;
+} Symbol;
+
+static Node* build_expr(Arena_t* a, int depth, size_t* nodes) {
+    Node* n = (Node*)arena_alloc(a, sizeof(Node));
+    (*nodes)++;
+    if (depth >= AST_MAX_DEPTH || rand_range(0, 3) == 0) {
+        if (rand_range(0, 1)) {
+            char name[24];
+            snprintf(name, sizeof(name), "var_%zu", rand_range(0, 999));
+            n->kind = NODE_IDENT;
+            n->name = arena_strdup(a, name);
+        } else {
+            n->kind = NODE_NUMBER;
+            n->value = (int)rand_range(0, 100);
+            n->name = NULL;
+        }
+        n->left = n->right = NULL;
+        return n;
+    }
+    n->kind = NODE_BINARY;
+    n->value = (int)rand_range(0, 3);  // Operator
+    n->name = NULL;
+    n->left = build_expr(a, depth + 1, nodes);
+    n->right = build_expr(a, depth + 1, nodes);
+    return n;
+}
+
+// Resolve identifiers into a scratch table (16 buckets)
+static void check_expr(Arena_t* a, const Node* n, Symbol** table) {
+    if (n->kind == NODE_IDENT) {
+        size_t h = (size_t)(unsigned char)n->name[4] % 16;
+        Symbol* s = (Symbol*)arena_alloc(a, sizeof(Symbol));
+        s->name = n->name;
+        s->next = table[h];
+        table[h] = s;
+    } else if (n->kind == NODE_BINARY) {
+        check_expr(a, n->left, table);
+        check_expr(a, n->right, table);
+    }
+}
+
+static long eval_expr(const Node* n) {
+    switch (n->kind) {
+        case NODE_NUMBER: return n->value;
+        case NODE_IDENT: return (long)n->name[4];
+        default: {
+            long l = eval_expr(n->left), r = eval_expr(n->right);
+            return n->value == 0 ? l + r : n->value == 1 ? l - r : n->value == 2 ? l ^ r : l | r;
+        }
+    }
+}
+
+static void run_ast(void) {
+    static Node* roots[AST_FUNCTIONS * AST_STATEMENTS];
+    rng_state = 0x9E3779B97F4A7C15ULL;
+    reset_peak_rss();
+    long rss_start = rss_kb("VmRSS:");
+    Latencies lat = {NULL, 0, 0};
+    size_t nodes = 0;
+    double start = now_ns();
+    Arena_t* a = arena_create(ARENA_DEFAULT_SIZE);
+    if (!a) exit(EXIT_FAILURE);
+    for (size_t m = 0; m < AST_MODULES; m++) {
+        arena_push_marker(a);  // Module scope
+        for (size_t f = 0; f < AST_FUNCTIONS; f++) {
+            double t = now_ns();
+            for (size_t s = 0; s < AST_STATEMENTS; s++) {
+                roots[f * AST_STATEMENTS + s] = build_expr(a, 0, &nodes);
+            }
+            arena_push_marker(a);  // Check scope
+            Symbol** table = (Symbol**)arena_calloc(a, 16, sizeof(Symbol*));
+            for (size_t s = 0; s < AST_STATEMENTS; s++) {
+                arena_push_marker(a);  // Statement scope
+                Symbol* local[16] = {NULL};
+                check_expr(a, roots[f * AST_STATEMENTS + s], local);
+                for (size_t b = 0; b < 16; b++) sink += (uintptr_t)local[b];
+                arena_pop_marker(a);
+            }
+            check_expr(a, roots[f * AST_STATEMENTS], table);
+            sink += (uintptr_t)table[0];
+            arena_pop_marker(a);
+            latency_add(&lat, t);
+        }
+        for (size_t r = 0; r < AST_FUNCTIONS * AST_STATEMENTS; r++) sink += (uintptr_t)eval_expr(roots[r]);
+        arena_pop_marker(a);
+    }
+    arena_destroy(a);
+    double secs = (now_ns() - start) / 1e9;
+    report("ast", (double)nodes, "Mnodes/s", secs, rss_kb("VmHWM:") - rss_start, &lat);
+}
+
+// Log workload: lines are tokenized in batches; each line is copied, split on spaces and every
+// token duplicated with arena_strdup into the batch's scope
+
+#define LOG_BATCH 256
+#define LOG_MAX_TOKENS 16
+
+// Synthetic access log of about `bytes` bytes, one line per request; *size gets its length
+static char* make_log(size_t bytes, size_t* size) {
+    static const char* levels[] = {"INFO", "INFO", "INFO", "WARN", "ERROR", "DEBUG"};
+    static const char* paths[] = {"/api/v1/items", "/api/v1/users", "/static/app.js", "/healthz", "/api/v2/search"};
+    rng_state = 0xD1B54A32D192ED03ULL;
+    char* log = (char*)malloc(bytes + 256);
+    if (!log) exit(EXIT_FAILURE);
+    size_t len = 0;
+    while (len < bytes) {
+        // Drawn into locals first: argument evaluation order is unspecified
+        size_t day = rand_range(1, 28), hour = rand_range(0, 23), min = rand_range(0, 59);
+        size_t sec = rand_range(0, 59), ms = rand_range(0, 999);
+        const char* level = levels[rand_range(0, 5)];
+        size_t worker = rand_range(1, 32);
+        size_t id = (size_t)(next_rand() & 0xFFFFFFFF);
+        const char* path = paths[rand_range(0, 4)];
+        size_t item = rand_range(1, 99999);
+        size_t status = rand_range(0, 9) ? (size_t)200 : rand_range(400, 503);
+        size_t latency = rand_range(1, 2000);
+        size_t body = rand_range(0, 1 << 20);
+        len += (size_t)snprintf(log + len, 256,
+                                "2024-05-%02zuT%02zu:%02zu:%02zu.%03zuZ %s [worker-%zu] request id=%08zx "
+                                "path=%s/%zu status=%zu latency_ms=%zu bytes=%zu\n",
+                                day, hour, min, sec, ms, level, worker, id, path, item, status, latency, body);
+    }
+    *size = len;
+    return log;
+}
+
+static void run_log(const char* log, size_t size) {
+    reset_peak_rss();
+    long rss_start = rss_kb("VmRSS:");
+    Latencies lat = {NULL, 0, 0};
+    double start = now_ns();
+    Arena_t* a = arena_create(ARENA_DEFAULT_SIZE);
+    if (!a) exit(EXIT_FAILURE);
+    const char* p = log;
+    const char* end = log + size;
+    while (p < end) {
+        double t = now_ns();
+        arena_push_marker(a);
+        for (size_t l = 0; l < LOG_BATCH && p < end; l++) {
+            const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+            if (!eol) eol = end;
+            size_t len = (size_t)(eol - p);
+            char* copy = (char*)arena_alloc(a, len + 1);
+            memcpy(copy, p, len);
+            copy[len] = '\0';
+            char** tokens = (char**)arena_alloc(a, LOG_MAX_TOKENS * sizeof(char*));
+            size_t count = 0;
+            for (char* tok = copy; *tok && count < LOG_MAX_TOKENS;) {
+                char* space = strchr(tok, ' ');
+                if (space) *space = '\0';
+                tokens[count++] = arena_strdup(a, tok);
+                if (!space) break;
+                tok = space + 1;
+            }
+            if (count > 6 && tokens[6][7] == '5') sink++;  // status=5xx
+            sink += count;
+            p = eol + 1;
+        }
+        arena_pop_marker(a);
+        latency_add(&lat, t);
+    }
+    arena_destroy(a);
+    double secs = (now_ns() - start) / 1e9;
+    report("log", (double)size, "MB/s", secs, rss_kb("VmHWM:") - rss_start, &lat);
+}
+
+// Request workload: each request gets its own scope for parsed headers, request objects and a
+// response buffer grown by appending; one in a thousand also needs a large scratch buffer
+
+#define REQUESTS 200000
+
+static void run_requests(void) {
+    static const char* headers[] = {"Host: example.com", "Accept: application/json", "User-Agent: bench/1.0",
+                                    "Accept-Encoding: gzip, deflate, br", "Cookie: session=0123456789abcdef",
+                                    "X-Request-Id: 7f9c2ba4e88f827d616045507605853e"};
+    rng_state = 0xBF58476D1CE4E5B9ULL;
+    reset_peak_rss();
+    long rss_start = rss_kb("VmRSS:");
+    Latencies lat = {NULL, 0, 0};
+    double start = now_ns();
+    Arena_t* a = arena_create(ARENA_DEFAULT_SIZE);
+    if (!a) exit(EXIT_FAILURE);
+    for (size_t r = 0; r < REQUESTS; r++) {
+        double t = now_ns();
+        arena_push_marker(a);
+        size_t count = rand_range(10, 30);
+        for (size_t h = 0; h < count; h++) sink += (uintptr_t)arena_strdup(a, headers[h % 6]);
+        for (size_t o = 0; o < 8; o++) {
+            size_t size = rand_range(64, 4096);
+            char* obj = (char*)arena_alloc(a, size);
+            obj[0] = obj[size - 1] = 1;
+        }
+        size_t cap = 256, used = 0, target = rand_range(1024, 32 * 1024);
+        char* body = (char*)arena_alloc(a, cap);
+        while (used < target) {
+            size_t chunk = rand_range(64, 512);
+            while (used + chunk > cap) {
+                body = (char*)arena_realloc(a, body, cap, cap * 2);
+                cap *= 2;
+            }
+            memset(body + used, 'x', chunk);
+            used += chunk;
+        }
+        sink += (uintptr_t)body[used / 2];
+        if (rand_range(0, 999) == 0) {
+            char* big = (char*)arena_alloc(a, 512 * 1024);
+            memset(big, 0, 512 * 1024);
+        }
+        arena_pop_marker(a);
+        latency_add(&lat, t);
+    }
+    arena_destroy(a);
+    double secs = (now_ns() - start) / 1e9;
+    report("requests", (double)REQUESTS, "Mreq/s", secs, rss_kb("VmHWM:") - rss_start, &lat);
+}
+
+int main(int argc, char** argv) {
+    size_t log_mb = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 32;
+    if (log_mb == 0 || log_mb > SIZE_MAX / (1024 * 1024)) {
+        fprintf(stderr, "usage: macro [log_megabytes]   (at least 1)\n");
+        return EXIT_FAILURE;
+    }
+    size_t log_size;
+    char* log = make_log(log_mb * 1024 * 1024, &log_size);
+
+    printf("%-9s %-7s %19s %11s %9s %9s %9s %9s\n", "workload", "alloc", "throughput", "peak RSS",
+           "p50 us", "p99 us", "p99.9 us", "max us");
+    run_ast();
+    run_log(log, log_size);
+    run_requests();
+    free(log);
+    if (sink == 1) puts("");
+    return EXIT_SUCCESS;
+}
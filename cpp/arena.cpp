@@ -1,94 +1,366 @@
 #include <cstdlib>
 #include <cstring>
 
+#ifdef ARENA_TRACE
+#include <chrono>
+#include <cstdio>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define ARENA_HAVE_MMAP 1
+#endif
+
 #include "arena.h"
 
-// Helper to align upwards
-size_t Arena::align_up(size_t n, size_t align) {
-    return (n + align - 1) & ~(align - 1);
+#ifdef ARENA_HAVE_MMAP
+// System page size, queried once
+static size_t page_size() {
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return page;
+}
+#endif
+
+// Return a block's memory to the system (unmapped if it was reserved, freed otherwise)
+void Arena::free_memory(Arena* block) {
+#ifdef ARENA_HAVE_MMAP
+    if (block->limit) {
+        munmap(block->base, (size_t)(block->limit - block->base));
+        return;
+    }
+#endif
+    free(block->base);
+}
+
+// Map huge-page-aligned memory: explicit huge pages if available, transparent ones otherwise
+uint8_t* Arena::map_huge(size_t* size) {
+#ifdef ARENA_HAVE_MMAP
+    if (*size > SIZE_MAX - 2 * ARENA_HUGE_PAGE_SIZE) return NULL;  // Rounding and over-mapping would wrap
+    size_t bytes = align_up(*size, ARENA_HUGE_PAGE_SIZE);
+    void* mem;
+#ifdef MAP_HUGETLB
+    mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+        *size = bytes;
+        return (uint8_t*)mem;
+    }
+#endif
+    // No reserved hugetlb pages: over-map, trim to a huge page boundary and ask for THP
+    size_t span = bytes + ARENA_HUGE_PAGE_SIZE;
+    mem = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return NULL;
+    uint8_t* raw = (uint8_t*)mem;
+    uint8_t* aligned = (uint8_t*)align_up((uintptr_t)raw, ARENA_HUGE_PAGE_SIZE);
+    if (aligned > raw) munmap(raw, (size_t)(aligned - raw));
+    size_t tail = (size_t)(raw + span - (aligned + bytes));
+    if (tail) munmap(aligned + bytes, tail);
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    *size = bytes;
+    return aligned;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+// Commit more of a reserved block so it extends to at least `need`
+bool Arena::commit(Arena* block, uint8_t* need) {
+#ifdef ARENA_HAVE_MMAP
+    if (!block->limit || need > block->limit) return false;
+    size_t committed = (size_t)(block->end - block->base);
+    size_t reserved = (size_t)(block->limit - block->base);
+    size_t want = (size_t)(need - block->base);
+    // Commit geometrically to keep mprotect calls rare; pages only become resident when touched
+    if (want < committed * 2) want = committed * 2;
+    want = align_up(want, page_size());
+    if (want > reserved) want = reserved;
+    if (mprotect(block->end, want - committed, PROT_READ | PROT_WRITE) != 0) return false;
+    block->end = block->base + want;
+    return true;
+#else
+    (void)block;
+    (void)need;
+    return false;
+#endif
+}
+
+// Record how far a rewound block was used and give its released pages back if past the threshold
+void Arena::trim(Arena* block, uint8_t* high) {
+    if (high < block->dirty) high = block->dirty;
+    block->dirty = high;
+#ifdef ARENA_HAVE_MMAP
+    if (this->trim_threshold == 0) return;
+    size_t released = (size_t)(high - block->bump);
+    if (released <= this->trim_keep || released - this->trim_keep < this->trim_threshold) return;
+    // Only whole pages inside the block can be released
+    size_t page = page_size();
+    uint8_t* from = (uint8_t*)align_up((uintptr_t)(block->bump + this->trim_keep), page);
+    uint8_t* to = (uint8_t*)align_up((uintptr_t)high, page);
+    uint8_t* stop = (uint8_t*)((uintptr_t)block->end & ~(uintptr_t)(page - 1));
+    if (to > stop) to = stop;
+    if (to <= from) return;
+    int advice = MADV_DONTNEED;
+#ifdef MADV_FREE
+    if (this->trim_lazy) advice = MADV_FREE;
+#endif
+    if (madvise(from, (size_t)(to - from), advice) == 0) block->dirty = from;
+#endif
+}
+
+// Free a single chained block's memory and header
+void Arena::free_block(Arena* block) {
+    free_memory(block);
+    if (block->markers) free(block->markers);  // Should be NULL for non-root
+    free(block);
 }
 
-// Helper to get the last block in the chain
-Arena* Arena::get_last_block(Arena* arena) {
-    Arena* cur = arena;
-    while (cur->next) {
-        cur = cur->next;
+// Hand a detached chain of blocks back to the root: cache what fits, free the rest
+void Arena::release_blocks(Arena* n) {
+    while (n) {
+        Arena* temp = n->next;
+        size_t cap = (size_t)(n->end - n->base);
+        if (this->cached_bytes + cap <= this->cache_limit) {
+            // A cached block is fully released: trim it like any rewound block
+            uint8_t* high = n->bump;
+            n->bump = n->base;
+            trim(n, high);
+            n->next = this->free_blocks;
+            this->free_blocks = n;
+            this->cached_bytes += cap;
+        } else {
+            free_block(n);
+        }
+        n = temp;
     }
-    return cur;
 }
 
-// Helper to compute current global position (total allocated bytes)
-size_t Arena::get_current_position(Arena* arena) {
-    size_t pos = 0;
-    Arena* cur = arena;
-    while (cur->next) {
-        pos += (size_t)(cur->end - cur->base);
-        cur = cur->next;
+// Take a block of at least `bytes` from the cache, preferring the smallest that holds `want`
+Arena* Arena::take_cached_block(size_t bytes, size_t want) {
+    Arena** best = NULL;
+    for (Arena** link = &this->free_blocks; *link; link = &(*link)->next) {
+        size_t cap = (size_t)((*link)->end - (*link)->base);
+        if (cap < bytes) continue;
+        if (!best) {
+            best = link;
+            continue;
+        }
+        size_t best_cap = (size_t)((*best)->end - (*best)->base);
+        // Smallest block that covers the full growth size, otherwise the largest that fits
+        if (cap >= want ? (best_cap < want || cap < best_cap) : (best_cap < want && cap > best_cap))
+            best = link;
     }
-    pos += (size_t)(cur->bump - cur->base);
-    return pos;
+    if (!best) return NULL;
+    Arena* block = *best;
+    *best = block->next;
+    this->cached_bytes -= (size_t)(block->end - block->base);
+    block->bump = block->base;
+    block->next = NULL;
+    return block;
 }
 
 
+// Set up the root fields around already obtained memory. On failure the arena is still complete
+// enough to be destroyed (which frees `base`)
+bool Arena::init_root(uint8_t* base, size_t size, uint8_t* limit) {
+    this->base = base;
+    this->bump = this->base;
+    this->end = this->base + size;
+    this->limit = limit;
+    this->dirty = this->base;
+    this->markers = (Marker*)malloc(ARENA_INITIAL_MARKER_CAP * sizeof(Marker));
+    this->marker_count = 0;
+    this->marker_cap = this->markers ? ARENA_INITIAL_MARKER_CAP : 0;
+    this->next = NULL;
+    this->current = this;
+    this->free_blocks = NULL;
+    this->cached_bytes = 0;
+    this->cache_limit = ARENA_DEFAULT_CACHE_LIMIT;
+    this->huge_pages = false;
+    this->trim_threshold = 0;
+    this->trim_keep = 0;
+    this->trim_lazy = false;
+    this->cleanups = NULL;
+    memset(&this->counters, 0, sizeof(this->counters));
+#ifdef ARENA_TRACE
+    // Tracing is best effort: without a buffer the arena simply records nothing
+    this->trace = (Trace*)malloc(sizeof(Trace));
+    if (this->trace) {
+        this->trace->next = 0;
+        this->trace->count = 0;
+    }
+#endif
+    return this->markers != NULL;
+}
+
 Arena::Arena (size_t initial_size) {
     if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+    initial_size = align_up(initial_size, ARENA_ALIGNMENT);
 
-    this->base = (uint8_t*)malloc(initial_size);
-    if (!this->base) {
+    uint8_t* mem = (uint8_t*)malloc(initial_size);
+    if (!mem) {
         exit(EXIT_FAILURE);
     }
 
-    this->bump = this->base;
-    this->end = this->base + initial_size;
-    this->markers = (size_t*)malloc(ARENA_INITIAL_MARKER_CAP * sizeof(size_t));
+    if (!init_root(mem, initial_size, NULL)) {
+        free_memory(this);
+        exit(EXIT_FAILURE);
+    }
+}
 
-    if (!this->markers)
-        free(this->base);
+// Like new Arena(initial_size), but NULL instead of exiting when memory runs out
+Arena* Arena::create(size_t initial_size) {
+    if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+    initial_size = align_up(initial_size, ARENA_ALIGNMENT);
 
-    this->marker_count = 0;
-    this->marker_cap = ARENA_INITIAL_MARKER_CAP;
-    this->next = NULL;
+    uint8_t* mem = (uint8_t*)malloc(initial_size);
+    if (!mem) return NULL;
+    Arena* arena = new (std::nothrow) Arena();
+    if (!arena) {
+        free(mem);
+        return NULL;
+    }
+    if (!arena->init_root(mem, initial_size, NULL)) {
+        delete arena;
+        return NULL;
+    }
+    return arena;
+}
+
+Arena::Arena (size_t initial_size, size_t reserve_size) {
+    if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+#ifdef ARENA_HAVE_MMAP
+    size_t page = page_size();
+    initial_size = align_up(initial_size, page);
+    reserve_size = align_up(reserve_size, page);
+    if (reserve_size < initial_size) reserve_size = initial_size;
+
+    // Map the whole range inaccessible, then commit the first `initial_size` bytes
+    void* mem = mmap(NULL, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        exit(EXIT_FAILURE);
+    }
+    if (mprotect(mem, initial_size, PROT_READ | PROT_WRITE) != 0) {
+        munmap(mem, reserve_size);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!init_root((uint8_t*)mem, initial_size, (uint8_t*)mem + reserve_size)) {
+        free_memory(this);
+        exit(EXIT_FAILURE);
+    }
+#else
+    // No virtual memory control: behave like a regular chained arena
+    (void)reserve_size;
+    initial_size = align_up(initial_size, ARENA_ALIGNMENT);
+    uint8_t* mem = (uint8_t*)malloc(initial_size);
+    if (!mem) {
+        exit(EXIT_FAILURE);
+    }
+    if (!init_root(mem, initial_size, NULL)) {
+        free_memory(this);
+        exit(EXIT_FAILURE);
+    }
+#endif
 }
 
 Arena::~Arena() {
-    Arena* cur = this;
+    run_cleanups(NULL);
+    Arena* cur = this->free_blocks;
     while (cur) {
         Arena* next = cur->next;
-        free(cur->base);
-        if (cur->markers) free(cur->markers);  // Only root has markers
+        free_block(cur);
         cur = next;
     }
+    cur = this->next;
+    while (cur) {
+        Arena* next = cur->next;
+        free_block(cur);
+        cur = next;
+    }
+    free_memory(this);
+    if (this->markers) free(this->markers);
+#ifdef ARENA_TRACE
+    free(this->trace);
+#endif
 }
 
-// // Allocate memory from the arena (grows via chaining if out of space)
-void* Arena::a_alloc(size_t bytes) {
-    if (bytes == 0) return NULL;
-    bytes = align_up(bytes, ARENA_ALIGNMENT);
-    Arena* last = get_last_block(this);
-    if (last->bump + bytes > last->end) {
-        // Grow by chaining a new block
-        size_t prev_size = (size_t)(last->end - last->base);
-        size_t new_size = prev_size * 2;
-        if (new_size < ARENA_DEFAULT_SIZE) new_size = ARENA_DEFAULT_SIZE;
-        if (new_size < bytes) new_size = bytes;
-        Arena* newarena = (Arena*)malloc(sizeof(Arena));
+// Slow path of allocation: chain a new block (reusing a cached one when possible)
+void* Arena::grow(size_t bytes, size_t align, size_t* padding) {
+    // The padded size below (and the aligned bump) must not wrap around
+    if (bytes > SIZE_MAX - align) return NULL;
+    Arena* last = this->current;
+    if (last->limit) {
+        // Reserved block: commit more pages in place instead of chaining
+        uint8_t* ptr = (uint8_t*)align_up((uintptr_t)last->bump, align);
+        if (ptr <= last->limit && bytes <= (size_t)(last->limit - ptr) && commit(last, ptr + bytes)) {
+            if (padding) *padding = (size_t)(ptr - last->bump);
+            this->counters.growths++;
+            this->counters.padding += (size_t)(ptr - last->bump);
+            last->bump = ptr + bytes;
+#ifdef ARENA_TRACE
+            trace_event(TRACE_GROW, NULL, (size_t)(last->end - last->base));
+            trace_event(TRACE_ALLOC, NULL, bytes);
+#endif
+            return ptr;
+        }
+    }
+    // Blocks are only guaranteed ARENA_ALIGNMENT, so reserve room to pad up to `align`
+    size_t needed = bytes + (align > ARENA_ALIGNMENT ? align - ARENA_ALIGNMENT : 0);
+    size_t prev_size = (size_t)(last->end - last->base);
+    size_t new_size = prev_size * 2;
+    if (new_size < ARENA_DEFAULT_SIZE) new_size = ARENA_DEFAULT_SIZE;
+    if (new_size < needed) new_size = needed;
+    new_size = align_up(new_size, ARENA_ALIGNMENT);
+    Arena* newarena = take_cached_block(needed, new_size);
+    if (!newarena) {
+        newarena = (Arena*)malloc(sizeof(Arena));
         if (!newarena) return NULL;
-        newarena->base = (uint8_t*)malloc(new_size);
-        if (!newarena->base) {
+        uint8_t* mem = this->huge_pages ? map_huge(&new_size) : NULL;
+        newarena->limit = mem ? mem + new_size : NULL;
+        if (!mem) mem = (uint8_t*)malloc(new_size);
+        if (!mem) {
             free(newarena);
             return NULL;
         }
+        newarena->base = mem;
         newarena->bump = newarena->base;
         newarena->end = newarena->base + new_size;
+        newarena->dirty = newarena->base;
         newarena->markers = NULL;  // Non-root has no markers
         newarena->marker_count = 0;
         newarena->marker_cap = 0;
         newarena->next = NULL;
-        last->next = newarena;
-        last = newarena;
+        newarena->current = NULL;  // Only the root tracks the current block
+        newarena->free_blocks = NULL;
+        newarena->cached_bytes = 0;
+        newarena->cache_limit = 0;
+        newarena->huge_pages = false;
+        newarena->trim_threshold = 0;
+        newarena->trim_keep = 0;
+        newarena->trim_lazy = false;
+        newarena->cleanups = NULL;
+        memset(&newarena->counters, 0, sizeof(newarena->counters));
+#ifdef ARENA_TRACE
+        newarena->trace = NULL;
+#endif
+        this->counters.mallocs++;
     }
-    void* ptr = last->bump;
-    last->bump += bytes;
+    this->counters.growths++;
+    this->counters.tail_waste += (size_t)(last->end - last->bump);
+    this->counters.chain_used += (size_t)(last->bump - last->base);
+    last->next = newarena;
+    this->current = newarena;
+    uint8_t* ptr = (uint8_t*)align_up((uintptr_t)newarena->bump, align);
+    if (padding) *padding = (size_t)(ptr - newarena->bump);
+    this->counters.padding += (size_t)(ptr - newarena->bump);
+    newarena->bump = ptr + bytes;
+#ifdef ARENA_TRACE
+    trace_event(TRACE_GROW, NULL, (size_t)(newarena->end - newarena->base));
+    trace_event(TRACE_ALLOC, NULL, bytes);
+#endif
     return ptr;
 }
 
@@ -110,31 +382,7 @@ void* Arena::a_realloc(void* ptr, size_t old_size, size_t new_size) {
         // Like alloc
         return a_alloc(new_size);
     }
-    old_size = align_up(old_size, ARENA_ALIGNMENT);
-    new_size = align_up(new_size, ARENA_ALIGNMENT);
-
-    // Find the block containing ptr
-    Arena* cur = this;
-    while (cur) {
-        if ((uint8_t*)ptr >= cur->base && (uint8_t*)ptr < cur->end) {
-            // Check if ptr is the last allocation in this block
-            if ((uint8_t*)ptr + old_size == cur->bump) {
-                // It's the last one; try to resize in place
-                size_t extra_needed = new_size > old_size ? new_size - old_size : 0;
-                if (cur->bump + extra_needed <= cur->end) {
-                    // Enough space: adjust bump
-                    cur->bump = (uint8_t*)ptr + new_size;
-                    return ptr;
-                } else if (new_size < old_size) {
-                    // Shrinking: adjust bump back
-                    cur->bump = (uint8_t*)ptr + new_size;
-                    return ptr;
-                }
-            }
-            break;  // Not last or can't resize: fall to copy
-        }
-        cur = cur->next;
-    }
+    if (a_expand(ptr, old_size, new_size)) return ptr;
 
     // Can't resize in place: allocate new and copy
     void* new_ptr = a_alloc(new_size);
@@ -145,71 +393,257 @@ void* Arena::a_realloc(void* ptr, size_t old_size, size_t new_size) {
     return new_ptr;
 }
 
-// Push a marker (saves current global position); operates on root
+// Resize the tail allocation in place: only the most recent allocation (at the bump of the
+// current block) can grow or shrink without moving, and only if it was made after the innermost
+// marker; growing an older one would leave its new end above what pop_marker rewinds to
+bool Arena::a_expand(void* ptr, size_t old_size, size_t new_size) {
+    Arena* cur = this->current;
+    uint8_t* p = (uint8_t*)ptr;
+    if (!p || p + old_size != cur->bump || before_marker(p)) return false;
+    if (new_size > (size_t)(cur->end - p)) {
+        // Not enough room: a reserved block can still commit more pages
+        if (!cur->limit || new_size > (size_t)(cur->limit - p) || !commit(cur, p + new_size)) return false;
+    }
+    if (new_size < old_size) note_peak();
+    cur->bump = p + new_size;
+#ifdef ARENA_TRACE
+    if (new_size > old_size) trace_event(TRACE_ALLOC, NULL, new_size - old_size);
+    else if (new_size < old_size) trace_event(TRACE_FREE, NULL, old_size - new_size);
+#endif
+    return true;
+}
+
+// Register a finalizer; the node is allocated in the arena so it goes away with the scope it guards
+bool Arena::add_cleanup(void (*fn)(void* arg), void* arg) {
+    Cleanup* node = (Cleanup*)a_alloc(sizeof(Cleanup));
+    if (!node) return false;
+    node->next = this->cleanups;
+    node->fn = fn;
+    node->arg = arg;
+    this->cleanups = node;
+    return true;
+}
+
+// Unlink each node before running it, so a finalizer that registers another one can't loop
+void Arena::run_cleanups(Cleanup* stop) {
+    while (this->cleanups != stop) {
+        Cleanup* node = this->cleanups;
+        this->cleanups = node->next;
+        node->fn(node->arg);
+    }
+}
+
+// Push a marker (saves the current block and its bump pointer); operates on root
 void Arena::push_marker() {
+    push_marker(NULL);
+}
+
+// Push a marker named `tag` in traces
+void Arena::push_marker(const char* tag) {
     if (this->marker_count == this->marker_cap) {
         size_t new_cap = this->marker_cap * 2;
-        size_t* new_markers = (size_t*)realloc(this->markers, new_cap * sizeof(size_t));
+        Marker* new_markers = (Marker*)realloc(this->markers, new_cap * sizeof(Marker));
         if (!new_markers) return; // Fail silently; marker not pushed
         this->markers = new_markers;
         this->marker_cap = new_cap;
     }
-    size_t pos = get_current_position(this);
-    this->markers[this->marker_count++] = pos;
+    Marker* m = &this->markers[this->marker_count++];
+    m->block = this->current;
+    m->bump = this->current->bump;
+    m->cleanups = this->cleanups;
+    m->chain_used = this->counters.chain_used;
+    m->padding = this->counters.padding;
+    m->tail_waste = this->counters.tail_waste;
+#ifdef ARENA_TRACE
+    m->tag = tag;
+    trace_event(TRACE_PUSH, tag, 0);
+#else
+    (void)tag;
+#endif
 }
 
 
-// Pop a marker (resets to last saved global position); frees later blocks if needed
+// Pop a marker (rewinds to the saved block and bump pointer); releases later blocks
 void Arena::pop_marker() {
     if (this->marker_count == 0) return;
-    size_t g = this->markers[--this->marker_count];
-    size_t c = 0;
-    Arena* cur = this;
-    Arena* prev = NULL;
-    while (cur) {
-        size_t block_cap = (size_t)(cur->end - cur->base);
-        if (g <= c + block_cap) {
-            cur->bump = cur->base + (g - c);
-            // Free all subsequent blocks
-            Arena* n = cur->next;
-            cur->next = NULL;
-            while (n) {
-                Arena* temp = n->next;
-                free(n->base);
-                if (n->markers) free(n->markers);  // Should be NULL for non-root
-                free(n);
-                n = temp;
-            }
-            break;
-        } else {
-            c += block_cap;
-            prev = cur;
-            cur = cur->next;
-        }
-    }
+    Marker m = this->markers[--this->marker_count];
+    // Finalizers run before the memory they may touch is rewound
+    run_cleanups(m.cleanups);
+    note_peak();
+    this->counters.chain_used = m.chain_used;
+    this->counters.padding = m.padding;
+    this->counters.tail_waste = m.tail_waste;
+    Arena* cur = m.block;
+    uint8_t* high = cur->bump;
+    cur->bump = m.bump;
+    this->current = cur;
+    trim(cur, high);
+    // Release all subsequent blocks to the cache
+    Arena* n = cur->next;
+    cur->next = NULL;
+    release_blocks(n);
+#ifdef ARENA_TRACE
+    trace_event(TRACE_POP, m.tag, 0);
+#endif
 }
 
-// Reset the entire arena chain (clears markers, resets to root base, frees chains)
+// Reset the entire arena chain (clears markers, resets to root base, releases chains)
 void Arena::reset() {
+    run_cleanups(NULL);
+    note_peak();
+#ifdef ARENA_TRACE
+    // Close the scopes of the markers dropped along with everything else, innermost first
+    while (this->marker_count > 0) {
+        trace_event(TRACE_POP, this->markers[--this->marker_count].tag, 0);
+    }
+#endif
+    this->counters.chain_used = 0;
+    this->counters.padding = 0;
+    this->counters.tail_waste = 0;
     this->marker_count = 0;
-    // Free all chained blocks
+    // Release all chained blocks to the cache
     Arena* n = this->next;
     this->next = NULL;
-    while (n) {
-        Arena* temp = n->next;
-        if (n->base) free(n->base);
-        if (n->markers) free(n->markers);
-        free(n);
-        n = temp;
-    }
+    release_blocks(n);
+    uint8_t* high = this->bump;
     this->bump = this->base;
+    this->current = this;
+    trim(this, high);
+#ifdef ARENA_TRACE
+    trace_event(TRACE_RESET, NULL, 0);
+#endif
+}
+
+// Cap the bytes kept in the released-block cache; frees cached blocks beyond the new cap
+void Arena::set_cache_limit(size_t bytes) {
+    this->cache_limit = bytes;
+    Arena* n = this->free_blocks;
+    this->free_blocks = NULL;
+    this->cached_bytes = 0;
+    release_blocks(n);
+}
+
+// Configure page trimming on pop_marker/reset
+void Arena::set_trim_policy(size_t threshold, size_t keep, bool lazy) {
+    this->trim_threshold = threshold;
+    this->trim_keep = keep;
+    this->trim_lazy = lazy;
+}
+
+// Back blocks chained from now on with huge pages
+void Arena::set_huge_pages(bool enable) {
+    this->huge_pages = enable;
+#if defined(ARENA_HAVE_MMAP) && defined(MADV_HUGEPAGE)
+    if (enable && this->limit) {
+        // Advise the huge-page-aligned interior of the root mapping
+        uint8_t* start = (uint8_t*)align_up((uintptr_t)this->base, ARENA_HUGE_PAGE_SIZE);
+        uint8_t* stop = (uint8_t*)((uintptr_t)this->limit & ~(uintptr_t)(ARENA_HUGE_PAGE_SIZE - 1));
+        if (stop > start) madvise(start, (size_t)(stop - start), MADV_HUGEPAGE);
+    }
+#endif
+}
+
+// Bytes of block memory held by the arena: the chain plus the released-block cache
+size_t Arena::footprint() const {
+    size_t bytes = this->cached_bytes;
+    for (const Arena* cur = this; cur; cur = cur->next) {
+        bytes += (size_t)(cur->end - cur->base);
+    }
+    return bytes;
+}
+
+ArenaStats Arena::stats() {
+    note_peak();
+    ArenaStats s;
+    s.bytes_used = used();
+    s.bytes_requested = s.bytes_used - this->counters.padding;
+    s.bytes_committed = footprint();
+    s.padding_waste = this->counters.padding;
+    s.tail_waste = this->counters.tail_waste;
+    s.block_count = 0;
+    for (const Arena* cur = this; cur; cur = cur->next) s.block_count++;
+    s.peak_used = this->counters.peak;
+    s.growth_events = this->counters.growths;
+    s.system_allocs = this->counters.mallocs;
+    s.marker_depth = this->marker_count;
+    return s;
+}
+
+#ifdef ARENA_TRACE
+// Overwrite the oldest event once the ring is full
+void Arena::trace_event(uint8_t type, const char* tag, size_t bytes) {
+    Trace* t = this->trace;
+    if (!t) return;
+    TraceEvent* e = &t->events[t->next];
+    e->ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    e->tag = tag;
+    e->bytes = bytes;
+    e->used = used();
+    e->type = type;
+    t->next = (t->next + 1) % ARENA_TRACE_CAPACITY;
+    if (t->count < ARENA_TRACE_CAPACITY) t->count++;
+}
+
+// Write a string as a JSON string literal
+static void write_json_string(FILE* f, const char* str) {
+    fputc('"', f);
+    for (const unsigned char* c = (const unsigned char*)str; *c; c++) {
+        if (*c == '"' || *c == '\\') fprintf(f, "\\%c", *c);
+        else if (*c < 0x20) fprintf(f, "\\u%04x", *c);
+        else fputc(*c, f);
+    }
+    fputc('"', f);
+}
+#endif
+
+// Events are written oldest first; once the ring has wrapped, the oldest scopes may have lost
+// their begin event (the viewer then shows them open from the start of the trace)
+bool Arena::dump_trace(const char* path) const {
+#ifdef ARENA_TRACE
+    const Trace* t = this->trace;
+    if (!t || !path) return false;
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fputs("{\"traceEvents\":[", f);
+    size_t first = (t->next + ARENA_TRACE_CAPACITY - t->count) % ARENA_TRACE_CAPACITY;
+    for (size_t i = 0; i < t->count; i++) {
+        const TraceEvent* e = &t->events[(first + i) % ARENA_TRACE_CAPACITY];
+        fputs(i ? ",\n" : "\n", f);
+        switch (e->type) {
+            case TRACE_ALLOC:
+            case TRACE_FREE:
+                fprintf(f, "{\"name\":\"used\",\"ph\":\"C\",\"args\":{\"bytes\":%zu}", e->used);
+                break;
+            case TRACE_GROW:
+                fprintf(f, "{\"name\":\"grow\",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"block\":%zu,\"used\":%zu}",
+                        e->bytes, e->used);
+                break;
+            case TRACE_PUSH:
+            case TRACE_POP:
+                fputs("{\"name\":", f);
+                write_json_string(f, e->tag ? e->tag : "marker");
+                fprintf(f, ",\"ph\":\"%s\",\"args\":{\"used\":%zu}", e->type == TRACE_PUSH ? "B" : "E", e->used);
+                break;
+            default:
+                fputs("{\"name\":\"reset\",\"ph\":\"i\",\"s\":\"t\"", f);
+                break;
+        }
+        fprintf(f, ",\"pid\":1,\"tid\":1,\"ts\":%.3f}", (double)e->ns / 1000.0);
+    }
+    fputs("\n]}\n", f);
+    return fclose(f) == 0;
+#else
+    (void)path;
+    return false;
+#endif
 }
 
 // Duplicate a string into the arena
 char* Arena::strdup(const char* str) {
     if (!str) return NULL;
     size_t len = strlen(str) + 1;
-    char* dup = (char*)a_alloc(len);
+    char* dup = (char*)a_alloc_packed(len);
     if (dup) memcpy(dup, str, len);
     return dup;
 }
@@ -2,6 +2,10 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 // Default initial memory size (adjust for your project, e.g., 1MB for compilers)
 #define ARENA_DEFAULT_SIZE (1024 * 1024)
@@ -9,56 +13,410 @@
 // Default initial capacity for marker stack
 #define ARENA_INITIAL_MARKER_CAP 16
 
-// Alignment boundary (e.g., 8 bytes for 64-bit)
+// Alignment boundary (e.g., 8 bytes for 64-bit); block ends are kept on this boundary
 #define ARENA_ALIGNMENT 8
 
+// Default cap on bytes kept in the released-block cache for reuse
+#define ARENA_DEFAULT_CACHE_LIMIT (16 * ARENA_DEFAULT_SIZE)
+
+// Huge page size used to align and round blocks when huge pages are enabled
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Define ARENA_TRACE (in every translation unit) to record allocation events per arena into a ring
+// buffer of ARENA_TRACE_CAPACITY entries, exported with dump_trace()
+#ifndef ARENA_TRACE_CAPACITY
+#define ARENA_TRACE_CAPACITY 8192
+#endif
+
+// Branch hints for the allocation fast path
+#if defined(__GNUC__) || defined(__clang__)
+#define ARENA_LIKELY(x) __builtin_expect(!!(x), 1)
+#define ARENA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define ARENA_LIKELY(x) (x)
+#define ARENA_UNLIKELY(x) (x)
+#endif
+
 #ifndef ARENA_H
 #define ARENA_H
 
+// Snapshot of an arena's allocation statistics. Byte counts describe the live allocations (what
+// pop_marker/reset would give back); peak and event counts run from creation.
+struct ArenaStats {
+    size_t bytes_requested; // Bytes asked for by live allocations
+    size_t bytes_used;      // Bytes consumed in the live chain: requested plus padding
+    size_t bytes_committed; // Block memory held: the live chain plus cached blocks
+    size_t padding_waste;   // Bytes skipped to align live allocations
+    size_t tail_waste;      // Bytes left unused at the end of live blocks that growth moved past
+    size_t block_count;     // Blocks in the live chain
+    size_t peak_used;       // Highest bytes_used reached
+    size_t growth_events;   // Allocations that took the slow path to a new or further-committed block
+    size_t system_allocs;   // Blocks obtained from the system instead of the block cache
+    size_t marker_depth;    // Markers currently pushed
+};
+
 class Arena {
     private:
+        // Finalizer registered with the arena; the nodes live in the arena itself
+        struct Cleanup {
+            Cleanup *next;          // Registered before this one
+            void (*fn)(void* arg);  // Finalizer
+            void *arg;              // Its argument
+        };
+
+        // Saved allocation position: the block that was current and its bump pointer
+        struct Marker {
+            Arena *block;    // Block being bumped when the marker was pushed
+            uint8_t *bump;   // Bump pointer of that block at push time
+            Cleanup *cleanups; // Head of the cleanup list at push time
+            size_t chain_used; // Bytes used in the blocks before `block` at push time
+            size_t padding;    // Padding counter at push time
+            size_t tail_waste; // Tail waste counter at push time
+#ifdef ARENA_TRACE
+            const char *tag;   // Scope name given to push_marker
+#endif
+        };
+
+        // Running counters behind stats(). Requested bytes are derived (used minus padding), so the
+        // allocation fast path only touches `padding`, and only when it actually skips bytes
+        struct Counters {
+            size_t padding;    // Alignment padding skipped by live allocations
+            size_t tail_waste; // Unused ends of live blocks left behind by growth
+            size_t chain_used; // Bytes used in the blocks before `current`
+            size_t peak;       // Highest usage seen so far
+            size_t growths;    // Slow-path growth events
+            size_t mallocs;    // Blocks obtained from the system
+        };
+
         uint8_t *base;       // Start of the memory block
         uint8_t *bump;       // Current allocation pointer
-        uint8_t *end;        // End of the memory block
-        size_t *markers;     // Dynamic array for markers (offsets from base)
+        uint8_t *end;        // End of the memory block (committed part for reserved blocks)
+        uint8_t *limit;      // End of the mapped address range; NULL for malloc'd blocks
+        uint8_t *dirty;      // High-water mark of pages that may still be resident
+        Marker *markers;     // Dynamic array of saved positions
         size_t marker_count; // Number of active markers
         size_t marker_cap;   // Capacity of markers array
         Arena *next;         // For chaining if resizable (optional)
+        Arena *current;      // Block currently being bumped (root only)
+        Arena *free_blocks;  // Released blocks kept for reuse (root only)
+        size_t cached_bytes; // Capacity held in free_blocks
+        size_t cache_limit;  // Max capacity kept in free_blocks
+        bool huge_pages;     // Back new blocks with huge pages (root only)
+        size_t trim_threshold; // Trim once this many released bytes sit above bump + trim_keep; 0 = off (root only)
+        size_t trim_keep;    // Bytes above the bump left resident by a trim (root only)
+        bool trim_lazy;      // Trim with MADV_FREE instead of MADV_DONTNEED (root only)
+        Cleanup *cleanups;   // Registered finalizers, newest first (root only)
+        Counters counters;   // Statistics (root only)
+
+#ifdef ARENA_TRACE
+        enum TraceType { TRACE_ALLOC, TRACE_FREE, TRACE_GROW, TRACE_PUSH, TRACE_POP, TRACE_RESET };
+
+        // One recorded event
+        struct TraceEvent {
+            uint64_t ns;     // Monotonic timestamp
+            const char *tag; // Scope name (push/pop)
+            size_t bytes;    // Allocation size, or new block size for growth
+            size_t used;     // Arena usage after the event
+            uint8_t type;    // TraceType
+        };
+
+        // Ring buffer of the most recent events
+        struct Trace {
+            TraceEvent events[ARENA_TRACE_CAPACITY];
+            size_t next;  // Slot the next event goes to
+            size_t count; // Events recorded, saturating at ARENA_TRACE_CAPACITY
+        };
+
+        Trace *trace;        // Event ring buffer; NULL if it couldn't be allocated (root only)
+
+        // Record an event (out of line, so tracing adds only a call to the fast path)
+        void trace_event(uint8_t type, const char* tag, size_t bytes);
+#endif
 
         // Helper to align upwards
         static size_t align_up(size_t n, size_t align);
 
-        // Helper to get the last block in the chain
-        static Arena* get_last_block(Arena* arena);
+        // Fields are filled in by init_root (create() only)
+        Arena () {}
+
+        // Set up the root fields around already obtained memory; false if the marker stack can't be allocated
+        bool init_root(uint8_t* base, size_t size, uint8_t* limit);
+
+        // Return a block's memory to the system (unmapped if it was reserved, freed otherwise)
+        static void free_memory(Arena* block);
 
-        // Helper to compute current global position (total allocated bytes)
-        static size_t get_current_position(Arena* arena);
+        // Map `*size` bytes (rounded up to huge pages) on a huge page boundary; NULL if mapping fails
+        static uint8_t* map_huge(size_t* size);
+
+        // Commit more of a reserved block so it extends to at least `need`; false if the reserve can't cover it
+        static bool commit(Arena* block, uint8_t* need);
+
+        // Record how far a rewound block was used and give its released pages back if past the threshold
+        void trim(Arena* block, uint8_t* high);
+
+        // Free a single chained block's memory and header
+        static void free_block(Arena* block);
+
+        // Hand a detached chain of blocks back to the root: cache what fits, free the rest
+        void release_blocks(Arena* n);
+
+        // Take a block of at least `bytes` from the cache, preferring the smallest that holds `want`
+        Arena* take_cached_block(size_t bytes, size_t want);
+
+        // Slow path of allocation: chain a new block that fits `bytes` at `align` and bump it
+        void* grow(size_t bytes, size_t align, size_t* padding);
+
+        // Allocate uninitialized storage for `n` objects of type T honoring alignof(T)
+        template <typename T>
+        void* alloc_storage(size_t n);
+
+        // Bytes currently used in the live chain
+        size_t used() const;
+
+        // Fold the current usage into the peak; called wherever usage is about to drop
+        void note_peak();
+
+        // True if `p` is below the bump saved by the innermost marker in the current block; moving
+        // the bump back there would let pop_marker rewind into data allocated before the marker
+        bool before_marker(const uint8_t* p) const;
+
+        // Run and unlink the finalizers registered after `stop`, newest first
+        void run_cleanups(Cleanup* stop);
+
+        // Finalizer make<T> registers for non-trivially destructible types
+        template <typename T>
+        static void destroy(void* obj);
 
     public:
         Arena (size_t initial_size);
 
+        // Heap-allocate an arena like `new Arena(initial_size)`, but return NULL instead of exiting
+        // when memory runs out; free it with delete
+        static Arena* create(size_t initial_size);
+
+        // Single contiguous arena: reserve `reserve_size` bytes of address space up front and commit
+        // pages on demand as the bump advances, so growth never chains (until the reserve runs out)
+        Arena (size_t initial_size, size_t reserve_size);
+
         // Allocate memory from the arena (grows via chaining if out of space)
         void* a_alloc(size_t bytes);
 
+        // Allocate memory aligned to `align` (any power of two); optionally reports the padding skipped
+        void* a_alloc_aligned(size_t bytes, size_t align, size_t* padding = NULL);
+
+        // Allocate unaligned bytes packed right after the previous allocation (strings, byte buffers)
+        void* a_alloc_packed(size_t bytes);
+
         // Allocate and zero-initialize
         void* a_calloc(size_t num, size_t size);
 
         // Reallocate memory in the arena (requires old_size; may allocate new space and copy)
         void* a_realloc(void* ptr, size_t old_size, size_t new_size);
 
-        // Push a marker (saves current global position); operates on root
+        // Grow or shrink `ptr` in place if it is the most recent allocation and was made after the
+        // innermost marker; false (nothing changed) otherwise
+        bool a_expand(void* ptr, size_t old_size, size_t new_size);
+
+        // Give back `ptr` if it is the most recent allocation (tail of the current block) and was made
+        // after the innermost marker; true if reclaimed
+        bool a_free(void* ptr, size_t size);
+
+        // Push a marker (saves the current block and its bump pointer); operates on root
         void push_marker();
 
-        // Pop a marker (resets to last saved global position); frees later blocks if needed
+        // Push a marker naming its scope `tag` in traces (the string must outlive the arena);
+        // the same as push_marker() when ARENA_TRACE is off
+        void push_marker(const char* tag);
+
+        // Pop a marker (rewinds to the saved block and bump pointer); releases later blocks
         void pop_marker();
 
-        // Reset the entire arena chain (clears markers, resets to root base, frees chains)
+        // Reset the entire arena chain (clears markers, resets to root base, releases chains)
         void reset();
 
+        // Cap the bytes kept in the released-block cache (0 disables it); trims the cache immediately
+        void set_cache_limit(size_t bytes);
+
+        // Return the pages of released memory to the OS on pop_marker/reset once more than `threshold`
+        // bytes sit above the bump plus `keep`; `keep` bytes stay resident so oscillating workloads
+        // don't fault the same pages back in. `lazy` uses MADV_FREE where available. 0 disables trimming
+        void set_trim_policy(size_t threshold, size_t keep, bool lazy = false);
+
+        // Back blocks chained from now on with 2 MB huge pages (MAP_HUGETLB, else MADV_HUGEPAGE,
+        // else plain malloc); a reserved arena also gets its reservation advised
+        void set_huge_pages(bool enable);
+
         // Duplicate a string into the arena
         char* strdup(const char* str);
 
+        // Bytes of block memory held by the arena: the chain plus the released-block cache
+        size_t footprint() const;
+
+        // Allocation statistics; always on, at the cost of one rarely taken branch in the fast path
+        ArenaStats stats();
+
+        // Markers currently pushed
+        size_t marker_depth() const;
+
+        // Write the recorded events to `path` as Chrome trace-event JSON (chrome://tracing, Perfetto):
+        // marker scopes as slices, usage as a counter, growth and resets as instants.
+        // False if ARENA_TRACE is off or the file can't be written
+        bool dump_trace(const char* path) const;
+
+        // Run fn(arg) when the enclosing marker is popped, on reset, or when the arena is destroyed,
+        // in reverse order of registration; false if the arena is out of memory
+        bool add_cleanup(void (*fn)(void* arg), void* arg);
+
+        // Construct a T in the arena; a non-trivial destructor is registered as a cleanup
+        template <typename T, typename... Args>
+        T* make(Args&&... args);
+
+        // Allocate `n` value-initialized T's (zeroed for trivial types); NULL if n is 0
+        template <typename T>
+        T* alloc_array(size_t n);
+
+        // Allocate storage for `n` T's without constructing or zeroing them; NULL if n is 0
+        template <typename T>
+        T* alloc_uninit(size_t n);
+
+        // Per-thread default arena: created on first use in each thread, destroyed when the thread exits
+        static Arena& thread_default();
+
         ~Arena();
 };
 
+// Helper to align upwards
+inline size_t Arena::align_up(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+// Allocate memory from the arena: align and bump the current block, chain a new one only when it is full
+inline void* Arena::a_alloc(size_t bytes) {
+    if (ARENA_UNLIKELY(bytes == 0)) return NULL;
+    Arena* last = this->current;
+    // Block ends are ARENA_ALIGNMENT-aligned, so the aligned bump never passes end
+    uint8_t* ptr = (uint8_t*)align_up((uintptr_t)last->bump, ARENA_ALIGNMENT);
+    if (ARENA_LIKELY(bytes <= (size_t)(last->end - ptr))) {
+        if (ARENA_UNLIKELY(ptr != last->bump)) this->counters.padding += (size_t)(ptr - last->bump);
+        last->bump = ptr + bytes;
+#ifdef ARENA_TRACE
+        trace_event(TRACE_ALLOC, NULL, bytes);
+#endif
+        return ptr;
+    }
+    return grow(bytes, ARENA_ALIGNMENT, NULL);
+}
+
+// Allocate aligned memory: pad the bump pointer of the current block up to `align`
+inline void* Arena::a_alloc_aligned(size_t bytes, size_t align, size_t* padding) {
+    if (ARENA_UNLIKELY(bytes == 0 || align == 0 || (align & (align - 1)) != 0)) return NULL;
+    Arena* last = this->current;
+    uintptr_t ptr = (uintptr_t)align_up((uintptr_t)last->bump, align);
+    if (ARENA_LIKELY(ptr <= (uintptr_t)last->end && bytes <= (uintptr_t)last->end - ptr)) {
+        if (padding) *padding = (size_t)(ptr - (uintptr_t)last->bump);
+        this->counters.padding += (size_t)(ptr - (uintptr_t)last->bump);
+        last->bump = (uint8_t*)ptr + bytes;
+#ifdef ARENA_TRACE
+        trace_event(TRACE_ALLOC, NULL, bytes);
+#endif
+        return (void*)ptr;
+    }
+    return grow(bytes, align, padding);
+}
+
+// Allocate packed bytes: bump the current block without any alignment
+inline void* Arena::a_alloc_packed(size_t bytes) {
+    if (ARENA_UNLIKELY(bytes == 0)) return NULL;
+    Arena* last = this->current;
+    if (ARENA_LIKELY(bytes <= (size_t)(last->end - last->bump))) {
+        void* ptr = last->bump;
+        last->bump += bytes;
+#ifdef ARENA_TRACE
+        trace_event(TRACE_ALLOC, NULL, bytes);
+#endif
+        return ptr;
+    }
+    return grow(bytes, 1, NULL);
+}
+
+// Give back the tail allocation by rewinding the bump; anything else stays until pop_marker/reset.
+// An allocation made before the innermost marker is left alone even at the tail
+inline bool Arena::a_free(void* ptr, size_t size) {
+    Arena* cur = this->current;
+    if (ptr && (uint8_t*)ptr + size == cur->bump && !before_marker((uint8_t*)ptr)) {
+        note_peak();
+        cur->bump = (uint8_t*)ptr;
+#ifdef ARENA_TRACE
+        trace_event(TRACE_FREE, NULL, size);
+#endif
+        return true;
+    }
+    return false;
+}
+
+inline bool Arena::before_marker(const uint8_t* p) const {
+    if (this->marker_count == 0) return false;
+    const Marker& top = this->markers[this->marker_count - 1];
+    return top.block == this->current && p < top.bump;
+}
+
+inline size_t Arena::marker_depth() const {
+    return this->marker_count;
+}
+
+inline size_t Arena::used() const {
+    return this->counters.chain_used + (size_t)(this->current->bump - this->current->base);
+}
+
+inline void Arena::note_peak() {
+    size_t now = used();
+    if (now > this->counters.peak) this->counters.peak = now;
+}
+
+template <typename T>
+inline void* Arena::alloc_storage(size_t n) {
+    if (n > SIZE_MAX / sizeof(T)) return NULL;
+    if (alignof(T) <= ARENA_ALIGNMENT) return a_alloc(n * sizeof(T));
+    return a_alloc_aligned(n * sizeof(T), alignof(T));
+}
+
+template <typename T>
+void Arena::destroy(void* obj) {
+    ((T*)obj)->~T();
+}
+
+template <typename T, typename... Args>
+inline T* Arena::make(Args&&... args) {
+    void* ptr = alloc_storage<T>(1);
+    if (!ptr) return NULL;
+    T* obj = new (ptr) T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value && !add_cleanup(&destroy<T>, obj)) {
+        obj->~T();
+        return NULL;
+    }
+    return obj;
+}
+
+template <typename T>
+inline T* Arena::alloc_array(size_t n) {
+    T* arr = (T*)alloc_storage<T>(n);
+    if (!arr) return NULL;
+    if (std::is_trivially_default_constructible<T>::value) {
+        memset((void*)arr, 0, n * sizeof(T));
+    } else {
+        for (size_t i = 0; i < n; i++) new (&arr[i]) T();
+    }
+    return arr;
+}
+
+template <typename T>
+inline T* Arena::alloc_uninit(size_t n) {
+    return (T*)alloc_storage<T>(n);
+}
+
+inline Arena& Arena::thread_default() {
+    static thread_local Arena arena(ARENA_DEFAULT_SIZE);
+    return arena;
+}
+
 #endif // ARENA_H
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#include "arena.h"
+
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+// Standard allocator over an Arena. deallocate() only reclaims the tail allocation, so a plain
+// std::vector still strands its old buffer on every growth; expand() exposes the arena's in-place
+// tail growth for containers that know to use it (see ArenaVector).
+template <typename T>
+class ArenaAllocator {
+    private:
+        Arena *arena; // Arena all allocations come from
+
+        template <typename U>
+        friend class ArenaAllocator;
+
+    public:
+        typedef T value_type;
+
+        explicit ArenaAllocator (Arena& arena) : arena(&arena) {}
+
+        template <typename U>
+        ArenaAllocator (const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+        // Storage for `n` T's honoring alignof(T); throws std::bad_alloc on failure
+        T* allocate(size_t n) {
+            T* ptr = this->arena->template alloc_uninit<T>(n ? n : 1);
+            if (!ptr) throw std::bad_alloc();
+            return ptr;
+        }
+
+        // Rewind the arena if `ptr` is its tail allocation; otherwise a no-op
+        void deallocate(T* ptr, size_t n) {
+            this->arena->a_free(ptr, (n ? n : 1) * sizeof(T));
+        }
+
+        // Grow or shrink `ptr` from `old_n` to `new_n` T's in place; false if it isn't the tail allocation
+        bool expand(T* ptr, size_t old_n, size_t new_n) {
+            if (new_n > SIZE_MAX / sizeof(T)) return false;
+            return this->arena->a_expand(ptr, (old_n ? old_n : 1) * sizeof(T), (new_n ? new_n : 1) * sizeof(T));
+        }
+
+        // The wrapped arena
+        Arena& get_arena() const {
+            return *this->arena;
+        }
+
+        template <typename U>
+        bool operator== (const ArenaAllocator<U>& other) const {
+            return this->arena == other.arena;
+        }
+
+        template <typename U>
+        bool operator!= (const ArenaAllocator<U>& other) const {
+            return this->arena != other.arena;
+        }
+};
+
+#endif // ARENA_ALLOCATOR_H
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARENA_HASH_MAP_SSE2 1
+#endif
+
+#include "arena.h"
+
+#ifndef ARENA_HASH_MAP_H
+#define ARENA_HASH_MAP_H
+
+// Slots probed together: one 16-byte load of control bytes
+#define ARENA_HASH_MAP_GROUP 16
+
+// Flat open-addressing hash map whose table lives in an Arena. Each slot has a control byte (empty,
+// deleted, or 7 bits of the key's hash), and lookups scan a group of 16 control bytes at once with
+// SSE2 (or a portable loop). When the table is full it grows in place if it is the arena's tail
+// allocation, rehashing inside the same memory; otherwise it moves to a new table and abandons the
+// old one to the arena. The map never frees its table: pop_marker/reset reclaims it, so dropping a
+// map of trivially destructible keys and values costs nothing. Non-trivial entries are destroyed by
+// the map's destructor, which must then run before the arena scope is popped.
+//
+// A table allocated before the innermost push_marker is never grown in place (Arena::a_expand
+// refuses to cross the marker), so pop_marker can't rewind into it; growth inside the scope moves
+// the table into the scope instead. A map must therefore not outlive the pop of a marker pushed
+// after it was created if it grew while that marker was pushed: its table went with the scope.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class ArenaHashMap {
+    public:
+        struct Entry {
+            K key;
+            V value;
+        };
+
+    private:
+        static const int8_t EMPTY = (int8_t)0x80;   // Never used; ends a probe
+        static const int8_t DELETED = (int8_t)0xFE; // Erased (or awaiting a rehash); probes continue past it
+
+        Arena *arena;      // Arena the table is allocated from
+        Entry *entries;    // Slots, followed in the same allocation by `cap` control bytes
+        int8_t *ctrl;      // Control bytes: EMPTY, DELETED, or the top 7 hash bits of a full slot
+        size_t cap;        // Slot count (a power of two, at least one group; 0 before the first insert)
+        size_t count;      // Full slots
+        size_t growth_left; // Inserts into EMPTY slots left before the table must be rehashed
+        Hash hasher;
+        Eq eq;
+
+        // Spread std::hash (often the identity for integers) over all 64 bits
+        static uint64_t mix(size_t h) {
+            uint64_t x = (uint64_t)h * 0x9E3779B97F4A7C15ull;
+            return x ^ (x >> 32);
+        }
+
+        static int8_t h2(uint64_t h) {
+            return (int8_t)(h >> 57);
+        }
+
+        static size_t table_bytes(size_t slots) {
+            return slots * sizeof(Entry) + slots;
+        }
+
+        // Keep the load factor at or below 7/8
+        static size_t max_load(size_t slots) {
+            return slots - slots / 8;
+        }
+
+        static unsigned lowest_bit(uint32_t mask) {
+#if defined(__GNUC__)
+            return (unsigned)__builtin_ctz(mask);
+#else
+            unsigned i = 0;
+            while (!(mask & 1)) {
+                mask >>= 1;
+                i++;
+            }
+            return i;
+#endif
+        }
+
+        // Bit i set where group[i] == b
+        static uint32_t match(const int8_t* group, int8_t b) {
+#ifdef ARENA_HASH_MAP_SSE2
+            __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b)));
+#else
+            uint32_t mask = 0;
+            for (unsigned i = 0; i < ARENA_HASH_MAP_GROUP; i++) {
+                if (group[i] == b) mask |= 1u << i;
+            }
+            return mask;
+#endif
+        }
+
+        // Bit i set where group[i] is EMPTY or DELETED (the only bytes with the sign bit set)
+        static uint32_t match_non_full(const int8_t* group) {
+#ifdef ARENA_HASH_MAP_SSE2
+            return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+            uint32_t mask = 0;
+            for (unsigned i = 0; i < ARENA_HASH_MAP_GROUP; i++) {
+                if (group[i] < 0) mask |= 1u << i;
+            }
+            return mask;
+#endif
+        }
+
+        // Group a hash starts probing at
+        size_t first_group(uint64_t h) const {
+            return (size_t)h & (this->cap / ARENA_HASH_MAP_GROUP - 1);
+        }
+
+        // Index of the entry holding `key`, or cap if there is none
+        size_t find_index(const K& key, uint64_t h) const {
+            if (this->cap == 0) return 0;
+            size_t groups_mask = this->cap / ARENA_HASH_MAP_GROUP - 1;
+            size_t g = first_group(h);
+            int8_t tag = h2(h);
+            for (size_t n = 0; n <= groups_mask; n++) {
+                const int8_t* group = this->ctrl + g * ARENA_HASH_MAP_GROUP;
+                uint32_t hits = match(group, tag);
+                while (hits) {
+                    size_t i = g * ARENA_HASH_MAP_GROUP + lowest_bit(hits);
+                    if (this->eq(this->entries[i].key, key)) return i;
+                    hits &= hits - 1;
+                }
+                if (match(group, EMPTY)) break;
+                g = (g + 1) & groups_mask;
+            }
+            return this->cap;
+        }
+
+        // First EMPTY or DELETED slot on the probe sequence of `h`; one exists while growth_left > 0
+        size_t find_slot(uint64_t h) const {
+            size_t groups_mask = this->cap / ARENA_HASH_MAP_GROUP - 1;
+            size_t g = first_group(h);
+            for (;;) {
+                uint32_t open = match_non_full(this->ctrl + g * ARENA_HASH_MAP_GROUP);
+                if (open) return g * ARENA_HASH_MAP_GROUP + lowest_bit(open);
+                g = (g + 1) & groups_mask;
+            }
+        }
+
+        // Move-construct `src` into the raw slot `dst` and end `src`'s lifetime
+        static void relocate(Entry* dst, Entry* src) {
+            new (dst) Entry(std::move(*src));
+            src->~Entry();
+        }
+
+        // Re-place every entry of a table whose control bytes were copied to `ctrl` and now span
+        // `cap` slots. Full slots are marked DELETED ("not placed yet") and each is moved to the
+        // first free slot of its probe sequence, swapping with a not-yet-placed entry if needed.
+        void rehash_in_place() {
+            for (size_t i = 0; i < this->cap; i++) {
+                this->ctrl[i] = this->ctrl[i] >= 0 ? DELETED : EMPTY;
+            }
+            for (size_t i = 0; i < this->cap; i++) {
+                if (this->ctrl[i] != DELETED) continue;
+                uint64_t h = mix(this->hasher(this->entries[i].key));
+                size_t target = find_slot(h);
+                if (target / ARENA_HASH_MAP_GROUP == i / ARENA_HASH_MAP_GROUP) {
+                    // Already in the first group with room: stays put
+                    this->ctrl[i] = h2(h);
+                } else if (this->ctrl[target] == EMPTY) {
+                    relocate(&this->entries[target], &this->entries[i]);
+                    this->ctrl[target] = h2(h);
+                    this->ctrl[i] = EMPTY;
+                } else {
+                    // Target holds an entry not placed yet: swap, then place the one that landed at i
+                    Entry tmp(std::move(this->entries[i]));
+                    this->entries[i].~Entry();
+                    relocate(&this->entries[i], &this->entries[target]);
+                    new (&this->entries[target]) Entry(std::move(tmp));
+                    this->ctrl[target] = h2(h);
+                    i--;
+                }
+            }
+            this->growth_left = max_load(this->cap) - this->count;
+        }
+
+        // Grow to `new_cap` slots: in place when the table is the arena's tail and was allocated after
+        // the innermost marker, else into a new table
+        void resize(size_t new_cap) {
+            if (this->entries && this->arena->a_expand(this->entries, table_bytes(this->cap), table_bytes(new_cap))) {
+                // The entries stay where they are; the control bytes move behind the larger slot array
+                int8_t* ctrl = (int8_t*)(this->entries + new_cap);
+                memmove(ctrl, this->ctrl, this->cap);
+                memset(ctrl + this->cap, EMPTY, new_cap - this->cap);
+                this->ctrl = ctrl;
+                this->cap = new_cap;
+                rehash_in_place();
+                return;
+            }
+
+            size_t align = alignof(Entry) > ARENA_ALIGNMENT ? alignof(Entry) : ARENA_ALIGNMENT;
+            Entry* entries = (Entry*)this->arena->a_alloc_aligned(table_bytes(new_cap), align);
+            if (!entries) throw std::bad_alloc();
+            int8_t* ctrl = (int8_t*)(entries + new_cap);
+            memset(ctrl, EMPTY, new_cap);
+
+            Entry* old_entries = this->entries;
+            int8_t* old_ctrl = this->ctrl;
+            size_t old_cap = this->cap;
+            this->entries = entries;
+            this->ctrl = ctrl;
+            this->cap = new_cap;
+            for (size_t i = 0; i < old_cap; i++) {
+                if (old_ctrl[i] < 0) continue;
+                uint64_t h = mix(this->hasher(old_entries[i].key));
+                size_t slot = find_slot(h);
+                relocate(&this->entries[slot], &old_entries[i]);
+                this->ctrl[slot] = h2(h);
+            }
+            // The old table is abandoned to the arena
+            this->growth_left = max_load(this->cap) - this->count;
+        }
+
+        // Make room for one more insert into an EMPTY slot
+        void make_room() {
+            if (this->cap == 0) {
+                resize(ARENA_HASH_MAP_GROUP);
+            } else if (this->count <= max_load(this->cap) / 2) {
+                // Mostly tombstones: clean them out without growing
+                rehash_in_place();
+            } else {
+                resize(this->cap * 2);
+            }
+        }
+
+    public:
+        // `expected` sizes the table to hold that many entries without growing
+        explicit ArenaHashMap (Arena& arena, size_t expected = 0)
+            : arena(&arena), entries(NULL), ctrl(NULL), cap(0), count(0), growth_left(0) {
+            if (expected) reserve(expected);
+        }
+
+        ArenaHashMap (const ArenaHashMap&) = delete;
+        ArenaHashMap& operator= (const ArenaHashMap&) = delete;
+
+        // Runs entry destructors for non-trivial types only; the table itself is left to the arena
+        ~ArenaHashMap() {
+            if (!std::is_trivially_destructible<Entry>::value) clear();
+        }
+
+        // Insert `key` with a V constructed from `args` unless it is present.
+        // Returns the value and whether it was inserted; throws std::bad_alloc when the arena is out of memory
+        template <typename... Args>
+        std::pair<V*, bool> emplace(const K& key, Args&&... args) {
+            uint64_t h = mix(this->hasher(key));
+            size_t i = find_index(key, h);
+            if (i < this->cap) return std::pair<V*, bool>(&this->entries[i].value, false);
+
+            size_t slot = this->cap ? find_slot(h) : 0;
+            if (this->cap == 0 || (this->ctrl[slot] == EMPTY && this->growth_left == 0)) {
+                make_room();
+                slot = find_slot(h);
+            }
+            if (this->ctrl[slot] == EMPTY) this->growth_left--;
+            new (&this->entries[slot]) Entry{key, V(std::forward<Args>(args)...)};
+            this->ctrl[slot] = h2(h);
+            this->count++;
+            return std::pair<V*, bool>(&this->entries[slot].value, true);
+        }
+
+        std::pair<V*, bool> insert(const K& key, const V& value) {
+            return emplace(key, value);
+        }
+
+        // Value of `key`, default-constructed if absent
+        V& operator[] (const K& key) {
+            return *emplace(key).first;
+        }
+
+        // Value of `key`, or NULL
+        V* find(const K& key) {
+            size_t i = find_index(key, mix(this->hasher(key)));
+            return i < this->cap ? &this->entries[i].value : NULL;
+        }
+
+        const V* find(const K& key) const {
+            size_t i = find_index(key, mix(this->hasher(key)));
+            return i < this->cap ? &this->entries[i].value : NULL;
+        }
+
+        bool contains(const K& key) const {
+            return find(key) != NULL;
+        }
+
+        // Remove `key`; false if it was absent
+        bool erase(const K& key) {
+            size_t i = find_index(key, mix(this->hasher(key)));
+            if (i >= this->cap) return false;
+            this->entries[i].~Entry();
+            this->count--;
+            // A group that already has an EMPTY byte stops every probe, so the slot can be EMPTY again
+            const int8_t* group = this->ctrl + i / ARENA_HASH_MAP_GROUP * ARENA_HASH_MAP_GROUP;
+            if (match(group, EMPTY)) {
+                this->ctrl[i] = EMPTY;
+                this->growth_left++;
+            } else {
+                this->ctrl[i] = DELETED;
+            }
+            return true;
+        }
+
+        // Size the table for `n` entries
+        void reserve(size_t n) {
+            if (n <= this->count + this->growth_left) return;
+            size_t slots = this->cap ? this->cap : ARENA_HASH_MAP_GROUP;
+            while (max_load(slots) < n) slots *= 2;
+            resize(slots);
+        }
+
+        // Remove every entry, keeping the table
+        void clear() {
+            for (size_t i = 0; i < this->cap; i++) {
+                if (this->ctrl[i] >= 0) this->entries[i].~Entry();
+            }
+            if (this->cap) memset(this->ctrl, EMPTY, this->cap);
+            this->count = 0;
+            this->growth_left = max_load(this->cap);
+        }
+
+        // Call f(key, value) for every entry, in table order
+        template <typename F>
+        void for_each(F f) {
+            for (size_t i = 0; i < this->cap; i++) {
+                if (this->ctrl[i] >= 0) f((const K&)this->entries[i].key, this->entries[i].value);
+            }
+        }
+
+        size_t size() const { return this->count; }
+        size_t capacity() const { return this->cap; }
+        bool empty() const { return this->count == 0; }
+};
+
+#endif // ARENA_HASH_MAP_H
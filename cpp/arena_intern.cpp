@@ -0,0 +1,123 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "arena_intern.h"
+
+// FNV-1a
+uint32_t ArenaIntern::hash(const char* str, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool ArenaIntern::alloc_table(size_t slots) {
+    Slot* table = (Slot*)this->arena->a_calloc(slots, sizeof(Slot));
+    if (!table) return false;
+    this->slots = table;
+    this->mask = slots - 1;
+    this->depth = this->arena->marker_depth();
+    return true;
+}
+
+ArenaIntern::ArenaIntern (Arena& arena, size_t expected) {
+    this->arena = &arena;
+    // Keep the load factor at or below 3/4 for `expected` strings
+    size_t slots = ARENA_INTERN_INITIAL_SLOTS;
+    while (slots / 4 * 3 < expected) slots *= 2;
+    this->initial = slots;
+    this->ids = NULL;
+    this->ids_cap = 0;
+    this->count = 0;
+    if (!alloc_table(slots)) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+ArenaIntern::Slot* ArenaIntern::find(const char* str, size_t len, uint32_t h) const {
+    size_t i = h & this->mask;
+    for (;;) {
+        Slot* slot = &this->slots[i];
+        if (!slot->str) return slot;
+        if (slot->hash == h && slot->len == len && memcmp(slot->str, str, len) == 0) return slot;
+        i = (i + 1) & this->mask;
+    }
+}
+
+// The old table is left to the arena; it is reclaimed with everything else
+bool ArenaIntern::grow() {
+    Slot* old = this->slots;
+    size_t old_slots = this->mask + 1;
+    if (!alloc_table(old_slots * 2)) return false;
+    for (size_t i = 0; i < old_slots; i++) {
+        if (!old[i].str) continue;
+        size_t j = old[i].hash & this->mask;
+        while (this->slots[j].str) j = (j + 1) & this->mask;
+        this->slots[j] = old[i];
+    }
+    return true;
+}
+
+const char* ArenaIntern::intern(const char* str) {
+    if (!str) return NULL;
+    return intern(str, strlen(str));
+}
+
+const char* ArenaIntern::intern(const char* str, size_t len) {
+    if (!str || len > UINT32_MAX) return NULL;
+    size_t depth = this->arena->marker_depth();
+    if (depth < this->depth) clear();  // The scope holding the table was popped
+    uint32_t h = hash(str, len);
+    Slot* slot = find(str, len, h);
+    if (slot->str) return slot->str;
+    // Storage taken now would be reclaimed by the nested scope's pop while the table still points at it
+    if (depth > this->depth) return NULL;
+
+    if ((this->count + 1) * 4 > (this->mask + 1) * 3) {
+        if (!grow()) return NULL;
+        slot = find(str, len, h);
+    }
+    if (this->count == this->ids_cap) {
+        size_t cap = this->ids_cap ? this->ids_cap * 2 : this->initial / 2;
+        const char** ids = (const char**)this->arena->a_realloc(this->ids, this->ids_cap * sizeof(const char*),
+                                                               cap * sizeof(const char*));
+        if (!ids) return NULL;
+        this->ids = ids;
+        this->ids_cap = cap;
+    }
+
+    Header* header = (Header*)this->arena->a_alloc(sizeof(Header) + len + 1);
+    if (!header) return NULL;
+    header->id = (uint32_t)this->count;
+    header->len = (uint32_t)len;
+    char* copy = (char*)(header + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    slot->str = copy;
+    slot->hash = h;
+    slot->len = (uint32_t)len;
+    this->ids[this->count++] = copy;
+    return copy;
+}
+
+uint32_t ArenaIntern::intern_id(const char* str, size_t len) {
+    const char* interned = intern(str, len);
+    return interned ? id_of(interned) : ARENA_INTERN_NO_ID;
+}
+
+const char* ArenaIntern::lookup(const char* str, size_t len) const {
+    if (!str || this->arena->marker_depth() < this->depth) return NULL;
+    return find(str, len, hash(str, len))->str;
+}
+
+void ArenaIntern::clear() {
+    this->ids = NULL;
+    this->ids_cap = 0;
+    this->count = 0;
+    if (!alloc_table(this->initial)) {
+        exit(EXIT_FAILURE);
+    }
+}
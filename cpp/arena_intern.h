@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "arena.h"
+
+#ifndef ARENA_INTERN_H
+#define ARENA_INTERN_H
+
+// Initial slot count of an interner's hash table (a power of two)
+#define ARENA_INTERN_INITIAL_SLOTS 64
+
+// Returned by intern_id() when the arena is out of memory
+#define ARENA_INTERN_NO_ID UINT32_MAX
+
+// String interner backed by an Arena: each distinct string is stored once, so equal strings share
+// one pointer (and one dense ID) and compare with ==. The hash table, the ID index and the strings
+// all live in the arena, in the marker scope the interner was created (or last cleared) in:
+// - While a later marker is pushed, strings already interned are still found, but new ones are
+//   refused (intern returns NULL), since they and any table growth would go with that scope.
+// - Once a pop_marker takes the arena below that scope, the contents are gone: lookup finds
+//   nothing and the next intern starts a fresh table. A reset, or a pop followed by a push back to
+//   the same depth, can't be told apart from an intact scope; clear() the interner after those.
+class ArenaIntern {
+    private:
+        // Stored in front of every interned string
+        struct Header {
+            uint32_t id;  // Dense ID, in interning order
+            uint32_t len; // Length without the terminator
+        };
+
+        // Open addressing slot; the cached hash and length reject most mismatches without touching the string
+        struct Slot {
+            const char *str; // Interned string (NULL when the slot is empty)
+            uint32_t hash;   // Hash of str
+            uint32_t len;    // Length of str
+        };
+
+        Arena *arena;       // Arena everything is allocated from
+        Slot *slots;        // Hash table (linear probing)
+        size_t mask;        // Slot count - 1
+        const char **ids;   // Interned strings by ID
+        size_t ids_cap;     // Capacity of ids
+        size_t count;       // Interned strings
+        size_t initial;     // Slot count clear() starts over with
+        size_t depth;       // Arena marker depth the table, ids and strings were allocated at
+
+        static uint32_t hash(const char* str, size_t len);
+
+        // Find the slot holding `str`, or the empty slot it would go into
+        Slot* find(const char* str, size_t len, uint32_t h) const;
+
+        // Double the table and reinsert every entry by its cached hash
+        bool grow();
+
+        // Allocate a zeroed table of `slots` slots; false on failure
+        bool alloc_table(size_t slots);
+
+    public:
+        // `expected` sizes the initial table to hold that many strings without growing
+        explicit ArenaIntern (Arena& arena, size_t expected = 0);
+
+        ArenaIntern (const ArenaIntern&) = delete;
+        ArenaIntern& operator= (const ArenaIntern&) = delete;
+
+        // Canonical copy of `str`; the same pointer for every equal string. NULL on failure, or if
+        // `str` is new and a marker was pushed after the interner's scope
+        const char* intern(const char* str);
+        const char* intern(const char* str, size_t len);
+
+        // Dense ID (0, 1, 2, ...) of `str`, interning it if needed; ARENA_INTERN_NO_ID on failure
+        uint32_t intern_id(const char* str, size_t len);
+
+        // Canonical copy of `str` if it was already interned (and its scope not popped), NULL otherwise
+        const char* lookup(const char* str, size_t len) const;
+
+        // String with ID `id`
+        const char* str(uint32_t id) const;
+
+        // ID and length of a pointer returned by intern()
+        static uint32_t id_of(const char* interned);
+        static size_t length(const char* interned);
+
+        // Number of distinct strings
+        size_t size() const;
+
+        // Forget every string and start a fresh table (call after the arena reclaimed the old one)
+        void clear();
+};
+
+inline const char* ArenaIntern::str(uint32_t id) const {
+    return this->ids[id];
+}
+
+inline uint32_t ArenaIntern::id_of(const char* interned) {
+    return ((const Header*)interned - 1)->id;
+}
+
+inline size_t ArenaIntern::length(const char* interned) {
+    return ((const Header*)interned - 1)->len;
+}
+
+inline size_t ArenaIntern::size() const {
+    return this->count;
+}
+
+#endif // ARENA_INTERN_H
@@ -0,0 +1,144 @@
+#include <cstring>
+
+#include "arena_pool.h"
+
+// Create an arena and fault in its root block so the first request doesn't pay for it
+Arena* ArenaPool::create_warm() {
+    Arena* arena = Arena::create(this->arena_size);
+    if (!arena) return NULL;
+    Policies p;
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        p = this->policies;
+    }
+    apply_policies(arena, p);
+    // Touching the root block through an allocation faults its pages in up front
+    arena->push_marker();
+    void* mem = arena->a_alloc(this->arena_size);
+    if (mem) memset(mem, 0, this->arena_size);
+    arena->pop_marker();
+    return arena;
+}
+
+void ArenaPool::apply_policies(Arena* arena, const Policies& p) {
+    arena->set_cache_limit(p.cache_limit);
+    arena->set_trim_policy(p.trim_threshold, p.trim_keep, p.trim_lazy);
+    arena->set_huge_pages(p.huge_pages);
+}
+
+void ArenaPool::reapply_idle() {
+    this->retained_bytes = 0;
+    for (Arena* arena : this->idle) {
+        apply_policies(arena, this->policies);
+        this->retained_bytes += arena->footprint();
+    }
+}
+
+ArenaPool::ArenaPool (size_t arena_size, size_t prewarm, size_t retain_limit) {
+    this->arena_size = arena_size ? arena_size : ARENA_DEFAULT_SIZE;
+    this->retain_limit = retain_limit;
+    this->retained_bytes = 0;
+    // The defaults of a new Arena
+    this->policies.cache_limit = ARENA_DEFAULT_CACHE_LIMIT;
+    this->policies.trim_threshold = 0;
+    this->policies.trim_keep = 0;
+    this->policies.trim_lazy = false;
+    this->policies.huge_pages = false;
+    this->idle.reserve(prewarm);
+    for (size_t i = 0; i < prewarm; i++) {
+        Arena* arena = create_warm();
+        if (!arena) break;
+        size_t bytes = arena->footprint();
+        if (this->retained_bytes + bytes > this->retain_limit) {
+            delete arena;
+            break;
+        }
+        this->retained_bytes += bytes;
+        this->idle.push_back(arena);
+    }
+}
+
+ArenaPool::~ArenaPool() {
+    for (Arena* arena : this->idle) {
+        delete arena;
+    }
+}
+
+// Take an idle arena (or create one)
+Arena* ArenaPool::acquire() {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (!this->idle.empty()) {
+            Arena* arena = this->idle.back();
+            this->idle.pop_back();
+            this->retained_bytes -= arena->footprint();
+            return arena;
+        }
+    }
+    return create_warm();
+}
+
+// Reset `arena` and return it to the pool, or destroy it if the pool is over its retain limit
+void ArenaPool::release(Arena* arena) {
+    if (!arena) return;
+    Policies p;
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        p = this->policies;
+    }
+    // Restore and reset outside the lock; it only touches this arena. The policies go first so the
+    // reset caches and trims by the pool's rules, not the borrower's
+    apply_policies(arena, p);
+    arena->reset();
+    size_t bytes = arena->footprint();
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->retained_bytes + bytes <= this->retain_limit) {
+            this->retained_bytes += bytes;
+            this->idle.push_back(arena);
+            return;
+        }
+    }
+    delete arena;
+}
+
+void ArenaPool::set_cache_limit(size_t bytes) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->policies.cache_limit = bytes;
+    reapply_idle();
+}
+
+void ArenaPool::set_trim_policy(size_t threshold, size_t keep, bool lazy) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->policies.trim_threshold = threshold;
+    this->policies.trim_keep = keep;
+    this->policies.trim_lazy = lazy;
+    reapply_idle();
+}
+
+void ArenaPool::set_huge_pages(bool enable) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->policies.huge_pages = enable;
+    reapply_idle();
+}
+
+// Number of idle arenas
+size_t ArenaPool::idle_count() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->idle.size();
+}
+
+// Bytes of block memory held by idle arenas
+size_t ArenaPool::retained() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->retained_bytes;
+}
+
+ArenaPool::Lease::Lease (ArenaPool& pool) {
+    this->pool = &pool;
+    this->arena = pool.acquire();
+}
+
+ArenaPool::Lease::~Lease() {
+    this->pool->release(this->arena);
+}
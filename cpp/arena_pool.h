@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "arena.h"
+
+#ifndef ARENA_POOL_H
+#define ARENA_POOL_H
+
+// Default cap on block memory kept by idle arenas in a pool
+#define ARENA_POOL_DEFAULT_RETAIN (64 * ARENA_DEFAULT_SIZE)
+
+// Pool of pre-warmed arenas for request-scoped work: acquire() pops an idle arena (creating one
+// only if the pool is empty) and release() resets it and keeps it for the next request, as long as
+// the idle arenas stay under the retain limit. The pool's cache, trim and huge-page policies are
+// put back on every arena it checks in, so settings a borrower changed don't reach the next one.
+// acquire/release are safe from any thread.
+class ArenaPool {
+    private:
+        std::mutex lock;            // Guards idle and retained_bytes
+        std::vector<Arena*> idle;   // Reset arenas ready to hand out
+        size_t retained_bytes;      // Sum of idle arenas' footprints
+        size_t retain_limit;        // Max retained_bytes; arenas beyond it are destroyed on release
+        size_t arena_size;          // Initial size of arenas the pool creates
+
+        // Settings every pooled arena gets, as passed to the Arena setters
+        struct Policies {
+            size_t cache_limit;
+            size_t trim_threshold;
+            size_t trim_keep;
+            bool trim_lazy;
+            bool huge_pages;
+        };
+
+        Policies policies;          // Guarded by lock
+
+        // Create an arena and fault in its root block so the first request doesn't pay for it; NULL
+        // if memory runs out
+        Arena* create_warm();
+
+        // Give `arena` the policies `p`
+        static void apply_policies(Arena* arena, const Policies& p);
+
+        // Apply changed policies to the idle arenas and recount what they retain (lock held)
+        void reapply_idle();
+
+    public:
+        // Scoped checkout: acquires on construction, releases on destruction
+        class Lease {
+            private:
+                ArenaPool *pool;
+                Arena *arena;
+
+            public:
+                Lease (ArenaPool& pool);
+
+                Lease (const Lease&) = delete;
+                Lease& operator= (const Lease&) = delete;
+
+                // NULL (and operator* invalid) if the pool couldn't create an arena
+                Arena& operator* () const { return *this->arena; }
+                Arena* operator-> () const { return this->arena; }
+                Arena* get() const { return this->arena; }
+
+                ~Lease();
+        };
+
+        // Pre-create `prewarm` arenas of `arena_size` bytes each (fewer if memory runs out)
+        ArenaPool (size_t arena_size, size_t prewarm, size_t retain_limit = ARENA_POOL_DEFAULT_RETAIN);
+
+        ArenaPool (const ArenaPool&) = delete;
+        ArenaPool& operator= (const ArenaPool&) = delete;
+
+        // Take an idle arena (or create one); it is empty and has no markers. NULL if out of memory
+        Arena* acquire();
+
+        // Restore the pool's policies, reset `arena` and return it to the pool, or destroy it if the
+        // pool is over its retain limit
+        void release(Arena* arena);
+
+        // Policies for pooled arenas, as the Arena setters of the same name; they apply to idle
+        // arenas now and to every arena checked in or created afterwards
+        void set_cache_limit(size_t bytes);
+        void set_trim_policy(size_t threshold, size_t keep, bool lazy = false);
+        void set_huge_pages(bool enable);
+
+        // Number of idle arenas
+        size_t idle_count();
+
+        // Bytes of block memory held by idle arenas
+        size_t retained();
+
+        ~ArenaPool();
+};
+
+#endif // ARENA_POOL_H
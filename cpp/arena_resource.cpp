@@ -0,0 +1,33 @@
+#include <new>
+
+#include "arena_resource.h"
+
+ArenaResource::ArenaResource (Arena& arena) {
+    this->arena = &arena;
+}
+
+// Allocate from the arena honoring `alignment`; pmr callers never get NULL
+void* ArenaResource::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;  // memory_resource must return a unique pointer even for 0 bytes
+    void* ptr = this->arena->a_alloc_aligned(bytes, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+// Rewind the arena if `ptr` is its tail allocation; otherwise a no-op
+void ArenaResource::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+    (void)alignment;
+    if (bytes == 0) bytes = 1;
+    this->arena->a_free(ptr, bytes);
+}
+
+// Equal only to a resource over the same arena
+bool ArenaResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    const ArenaResource* res = dynamic_cast<const ArenaResource*>(&other);
+    return res && res->arena == this->arena;
+}
+
+// The wrapped arena
+Arena& ArenaResource::get_arena() const {
+    return *this->arena;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "arena.h"
+
+#ifndef ARENA_RESOURCE_H
+#define ARENA_RESOURCE_H
+
+// std::pmr::memory_resource over an Arena, so pmr containers allocate from it and vanish together
+// on pop_marker/reset. Deallocation only reclaims the most recent allocation; everything else is
+// released with the arena. Not thread-safe, like the Arena it wraps.
+class ArenaResource : public std::pmr::memory_resource {
+    private:
+        Arena *arena; // Arena all allocations come from
+
+    protected:
+        // Allocate from the arena honoring `alignment`; throws std::bad_alloc on failure
+        void* do_allocate(size_t bytes, size_t alignment) override;
+
+        // Rewind the arena if `ptr` is its tail allocation; otherwise a no-op
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+
+        // Equal only to a resource over the same arena
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    public:
+        explicit ArenaResource (Arena& arena);
+
+        // The wrapped arena
+        Arena& get_arena() const;
+};
+
+#endif // ARENA_RESOURCE_H
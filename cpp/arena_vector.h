@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "arena_allocator.h"
+
+#ifndef ARENA_VECTOR_H
+#define ARENA_VECTOR_H
+
+// Vector whose buffer lives in an Arena. While the buffer is the arena's tail allocation it grows
+// in place through ArenaAllocator::expand, so neither a copy nor a stranded old buffer is paid;
+// otherwise it moves to a new buffer of twice the capacity. Trivially destructible elements are
+// never destroyed one by one, and trivially copyable ones are relocated with memcpy.
+//
+// Growth never crosses a marker: a buffer allocated before the innermost push_marker is moved
+// rather than extended, so pop_marker can't rewind into it. The moved buffer belongs to the scope,
+// so a vector grown inside a scope pushed after it was created must not be used after that pop.
+template <typename T>
+class ArenaVector {
+    private:
+        ArenaAllocator<T> alloc; // Allocator over the owning arena
+        T *items;                // Buffer (NULL until the first element)
+        size_t count;            // Constructed elements
+        size_t cap;              // Capacity of items
+
+        // Destroy items[from, to)
+        void destroy(size_t from, size_t to) {
+            if (!std::is_trivially_destructible<T>::value) {
+                for (size_t i = from; i < to; i++) this->items[i].~T();
+            }
+        }
+
+        // Move the elements into `fresh` (of capacity `new_cap`) and drop the old buffer
+        void adopt(T* fresh, size_t new_cap) {
+            if (std::is_trivially_copyable<T>::value) {
+                if (this->count) memcpy((void*)fresh, (const void*)this->items, this->count * sizeof(T));
+            } else {
+                for (size_t i = 0; i < this->count; i++) {
+                    new (&fresh[i]) T(std::move(this->items[i]));
+                }
+                destroy(0, this->count);
+            }
+            if (this->items) this->alloc.deallocate(this->items, this->cap);
+            this->items = fresh;
+            this->cap = new_cap;
+        }
+
+        // Move the elements into a buffer of exactly `new_cap`, in place when possible
+        void relocate(size_t new_cap) {
+            if (this->items && this->alloc.expand(this->items, this->cap, new_cap)) {
+                this->cap = new_cap;
+                return;
+            }
+            adopt(this->alloc.allocate(new_cap), new_cap);
+        }
+
+        // Geometric growth step for holding at least `needed` elements
+        size_t next_cap(size_t needed) const {
+            size_t new_cap = this->cap ? this->cap * 2 : 8;
+            return new_cap < needed ? needed : new_cap;
+        }
+
+        // Make room for at least `needed` elements, growing geometrically
+        void grow(size_t needed) {
+            relocate(next_cap(needed));
+        }
+
+        // Slow path of emplace_back. The new element is built in the new buffer before the old
+        // elements move out, so arguments referring into this vector (v.push_back(v[0])) stay valid
+        template <typename... Args>
+        T& grow_emplace(Args&&... args) {
+            size_t new_cap = next_cap(this->count + 1);
+            if (this->items && this->alloc.expand(this->items, this->cap, new_cap)) {
+                this->cap = new_cap;
+                return *new (&this->items[this->count++]) T(std::forward<Args>(args)...);
+            }
+            T* fresh = this->alloc.allocate(new_cap);
+            new (&fresh[this->count]) T(std::forward<Args>(args)...);
+            adopt(fresh, new_cap);
+            return this->items[this->count++];
+        }
+
+    public:
+        typedef T value_type;
+        typedef T* iterator;
+        typedef const T* const_iterator;
+
+        explicit ArenaVector (Arena& arena) : alloc(arena), items(NULL), count(0), cap(0) {}
+
+        ArenaVector (const ArenaVector&) = delete;
+        ArenaVector& operator= (const ArenaVector&) = delete;
+
+        // Take over `other`'s buffer; `other` is left empty
+        ArenaVector (ArenaVector&& other) : alloc(other.alloc), items(other.items), count(other.count), cap(other.cap) {
+            other.items = NULL;
+            other.count = 0;
+            other.cap = 0;
+        }
+
+        ArenaVector& operator= (ArenaVector&& other) {
+            if (this != &other) {
+                clear();
+                if (this->items) this->alloc.deallocate(this->items, this->cap);
+                this->alloc = other.alloc;
+                this->items = other.items;
+                this->count = other.count;
+                this->cap = other.cap;
+                other.items = NULL;
+                other.count = 0;
+                other.cap = 0;
+            }
+            return *this;
+        }
+
+        // Destroys the elements; the buffer is reclaimed only if it is still the arena's tail
+        ~ArenaVector() {
+            clear();
+            if (this->items) this->alloc.deallocate(this->items, this->cap);
+        }
+
+        // Ensure room for `n` elements without further reallocation
+        void reserve(size_t n) {
+            if (n > this->cap) relocate(n);
+        }
+
+        // Release unused capacity; only effective while the buffer is the arena's tail
+        void shrink_to_fit() {
+            if (this->items && this->count < this->cap && this->alloc.expand(this->items, this->cap, this->count)) {
+                this->cap = this->count ? this->count : 1;
+            }
+        }
+
+        template <typename... Args>
+        T& emplace_back(Args&&... args) {
+            if (this->count == this->cap) return grow_emplace(std::forward<Args>(args)...);
+            T* slot = new (&this->items[this->count]) T(std::forward<Args>(args)...);
+            this->count++;
+            return *slot;
+        }
+
+        void push_back(const T& value) {
+            emplace_back(value);
+        }
+
+        void push_back(T&& value) {
+            emplace_back(std::move(value));
+        }
+
+        // Append `n` elements copied from `src` (which must not point into this vector)
+        void append(const T* src, size_t n) {
+            if (this->count + n > this->cap) grow(this->count + n);
+            if (std::is_trivially_copyable<T>::value) {
+                if (n) memcpy((void*)(this->items + this->count), (const void*)src, n * sizeof(T));
+            } else {
+                for (size_t i = 0; i < n; i++) new (&this->items[this->count + i]) T(src[i]);
+            }
+            this->count += n;
+        }
+
+        // Append the elements of [first, last)
+        template <typename It>
+        void append(It first, It last) {
+            for (; first != last; ++first) emplace_back(*first);
+        }
+
+        void pop_back() {
+            this->count--;
+            destroy(this->count, this->count + 1);
+        }
+
+        // Grow with value-initialized elements or destroy the excess ones
+        void resize(size_t n) {
+            if (n < this->count) {
+                destroy(n, this->count);
+            } else {
+                if (n > this->cap) grow(n);
+                for (size_t i = this->count; i < n; i++) new (&this->items[i]) T();
+            }
+            this->count = n;
+        }
+
+        void clear() {
+            destroy(0, this->count);
+            this->count = 0;
+        }
+
+        size_t size() const { return this->count; }
+        size_t capacity() const { return this->cap; }
+        bool empty() const { return this->count == 0; }
+
+        T* data() { return this->items; }
+        const T* data() const { return this->items; }
+
+        T& operator[] (size_t i) { return this->items[i]; }
+        const T& operator[] (size_t i) const { return this->items[i]; }
+
+        T& back() { return this->items[this->count - 1]; }
+        const T& back() const { return this->items[this->count - 1]; }
+
+        iterator begin() { return this->items; }
+        iterator end() { return this->items + this->count; }
+        const_iterator begin() const { return this->items; }
+        const_iterator end() const { return this->items + this->count; }
+};
+
+#endif // ARENA_VECTOR_H
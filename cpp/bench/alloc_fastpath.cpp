@@ -0,0 +1,38 @@
+// Per-call cost of Arena::a_alloc for small fixed-size nodes.
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/alloc_fastpath.cpp cpp/arena.cpp -o alloc_fastpath
+
+#include "../arena.h"
+
+#include <chrono>
+#include <cstdio>
+
+// Allocations per reset; keeps every allocation inside the root block
+#define BATCH 4096
+
+static double run(Arena& arena, size_t size, size_t rounds) {
+    uintptr_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            sink += (uintptr_t)arena.a_alloc(size);
+        }
+        arena.reset();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (sink == 1) std::puts("");  // Keep the allocations observable
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return ns / (double)(rounds * BATCH);
+}
+
+int main(void) {
+    Arena arena(BATCH * 128);
+    const size_t sizes[] = {8, 16, 24, 64, 128};
+    const size_t rounds = 20000;
+
+    run(arena, 16, rounds / 10);  // Warm up
+    for (size_t s : sizes) {
+        std::printf("a_alloc(%3zu): %6.3f ns/op\n", s, run(arena, s, rounds));
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,404 @@
+// Compare benchmark runs against stored baseline runs and flag regressions. Every file is the JSON
+// written by one `micro --json` process: for each case, the ns/op of every repetition. Repetitions
+// inside one process share its heap layout, frequency and placement, so they understate the noise
+// between processes; each side is therefore several independent runs, and a case is judged on the
+// ratio of medians of the per-run medians (current / baseline) with a 99% bootstrap interval that
+// resamples whole runs, then the repetitions inside each. A case is a regression when its median is
+// slower by more than the threshold and the interval excludes "no change".
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/compare.cpp -o compare
+// Usage: for i in 1 2 3 4 5; do ./micro --json > base$i.json; done       (store a baseline)
+//        for i in 1 2 3 4 5; do ./micro --json > cur$i.json; done        (after the change)
+//        ./compare [--threshold percent] [--min-runs n] [--match substring]...
+//                  --base base*.json --current cur*.json
+//
+// --threshold defaults to 5 and --min-runs to 5; a case with fewer runs on either side is reported
+// but never flagged, since with few runs the bootstrap interval comes out too narrow. With --match,
+// only cases whose name contains one of the substrings are compared (e.g. --match a_alloc --match
+// push/pop --match a_realloc). Exits with 1 if any compared case regressed or a baseline case is
+// missing from the current runs, 2 on bad usage, unreadable input, or when no case could be
+// compared at all.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// Bootstrap resamples per case
+#define BOOTSTRAP_ROUNDS 4000
+
+// Two-sided confidence of the ratio interval. Wide on purpose: a whole table of cases is judged
+// at once, and a false alarm on any of them fails the comparison
+#define CONFIDENCE 0.99
+
+// Samples of one case: the ns/op repetitions of each run (file) that measured it
+typedef std::vector<std::vector<double>> Runs;
+
+// Parsed JSON value; only what the result files need (numbers, strings, arrays, objects)
+struct JsonValue {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    double number = 0;
+    std::string str;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    // Member `key` of an object, or NULL
+    const JsonValue* get(const char* key) const {
+        for (const auto& m : this->members) {
+            if (m.first == key) return &m.second;
+        }
+        return NULL;
+    }
+};
+
+// Recursive-descent parser; on failure `error` says what was expected and where
+class JsonParser {
+    private:
+        const char *text;
+        const char *pos;
+
+        void skip_space() {
+            while (*this->pos == ' ' || *this->pos == '\n' || *this->pos == '\r' || *this->pos == '\t') this->pos++;
+        }
+
+        bool fail(const char* what) {
+            if (this->error.empty()) {
+                char buf[128];
+                std::snprintf(buf, sizeof(buf), "expected %s at offset %zu", what, (size_t)(this->pos - this->text));
+                this->error = buf;
+            }
+            return false;
+        }
+
+        bool literal(const char* word) {
+            size_t len = strlen(word);
+            if (strncmp(this->pos, word, len) != 0) return fail(word);
+            this->pos += len;
+            return true;
+        }
+
+        bool parse_string(std::string& out) {
+            if (*this->pos != '"') return fail("string");
+            this->pos++;
+            while (*this->pos != '"') {
+                char c = *this->pos++;
+                if (c == '\0') return fail("closing quote");
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                c = *this->pos++;
+                switch (c) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': {
+                        // Names are ASCII; anything wider becomes '?'
+                        char hex[5] = {0};
+                        for (int i = 0; i < 4; i++) {
+                            if (!this->pos[i]) return fail("\\u escape");
+                            hex[i] = this->pos[i];
+                        }
+                        this->pos += 4;
+                        long code = strtol(hex, NULL, 16);
+                        out += code < 0x80 ? (char)code : '?';
+                        break;
+                    }
+                    case '\0': return fail("escape");
+                    default: out += c; break;  // \" \\ \/
+                }
+            }
+            this->pos++;
+            return true;
+        }
+
+        bool parse_value(JsonValue& v) {
+            skip_space();
+            char c = *this->pos;
+            if (c == '{') {
+                v.type = JsonValue::OBJECT;
+                this->pos++;
+                skip_space();
+                if (*this->pos == '}') {
+                    this->pos++;
+                    return true;
+                }
+                for (;;) {
+                    skip_space();
+                    std::pair<std::string, JsonValue> member;
+                    if (!parse_string(member.first)) return false;
+                    skip_space();
+                    if (*this->pos != ':') return fail("':'");
+                    this->pos++;
+                    if (!parse_value(member.second)) return false;
+                    v.members.push_back(std::move(member));
+                    skip_space();
+                    if (*this->pos == ',') {
+                        this->pos++;
+                    } else if (*this->pos == '}') {
+                        this->pos++;
+                        return true;
+                    } else {
+                        return fail("',' or '}'");
+                    }
+                }
+            }
+            if (c == '[') {
+                v.type = JsonValue::ARRAY;
+                this->pos++;
+                skip_space();
+                if (*this->pos == ']') {
+                    this->pos++;
+                    return true;
+                }
+                for (;;) {
+                    v.items.emplace_back();
+                    if (!parse_value(v.items.back())) return false;
+                    skip_space();
+                    if (*this->pos == ',') {
+                        this->pos++;
+                    } else if (*this->pos == ']') {
+                        this->pos++;
+                        return true;
+                    } else {
+                        return fail("',' or ']'");
+                    }
+                }
+            }
+            if (c == '"') {
+                v.type = JsonValue::STRING;
+                return parse_string(v.str);
+            }
+            if (c == 't' || c == 'f') {
+                v.type = JsonValue::BOOL;
+                v.number = c == 't';
+                return literal(c == 't' ? "true" : "false");
+            }
+            if (c == 'n') {
+                v.type = JsonValue::NUL;
+                return literal("null");
+            }
+            char* end;
+            v.type = JsonValue::NUMBER;
+            v.number = strtod(this->pos, &end);
+            if (end == this->pos) return fail("value");
+            this->pos = end;
+            return true;
+        }
+
+    public:
+        std::string error;
+
+        JsonParser (const char* text) : text(text), pos(text) {}
+
+        // Parse the whole text as one value
+        bool parse(JsonValue& v) {
+            if (!parse_value(v)) return false;
+            skip_space();
+            if (*this->pos != '\0') return fail("end of input");
+            return true;
+        }
+};
+
+// Append the run in a `micro --json` file to `out` (case name -> runs); false (with a message) on failure
+static bool load_results(const char* path, std::map<std::string, Runs>& out) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        std::fprintf(stderr, "compare: cannot open %s\n", path);
+        return false;
+    }
+    std::string text;
+    char buf[65536];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+
+    JsonValue root;
+    JsonParser parser(text.c_str());
+    if (!parser.parse(root)) {
+        std::fprintf(stderr, "compare: %s: %s\n", path, parser.error.c_str());
+        return false;
+    }
+    const JsonValue* results = root.get("results");
+    if (root.type != JsonValue::OBJECT || !results || results->type != JsonValue::ARRAY) {
+        std::fprintf(stderr, "compare: %s: no \"results\" array\n", path);
+        return false;
+    }
+    for (const JsonValue& r : results->items) {
+        const JsonValue* name = r.get("name");
+        const JsonValue* samples = r.get("samples");
+        if (!name || name->type != JsonValue::STRING || !samples || samples->type != JsonValue::ARRAY) {
+            std::fprintf(stderr, "compare: %s: result without \"name\" and \"samples\"\n", path);
+            return false;
+        }
+        Runs& runs = out[name->str];
+        runs.emplace_back();
+        std::vector<double>& values = runs.back();
+        for (const JsonValue& s : samples->items) {
+            if (s.type == JsonValue::NUMBER) values.push_back(s.number);
+        }
+        if (values.empty()) {
+            std::fprintf(stderr, "compare: %s: \"%s\" has no samples\n", path, name->str.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// Fixed-seed xorshift64 so a comparison is reproducible
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static size_t rand_index(size_t n) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (size_t)(rng_state % n);
+}
+
+// Median of the per-run medians
+static double run_median(const Runs& runs) {
+    std::vector<double> m(runs.size());
+    for (size_t i = 0; i < runs.size(); i++) m[i] = median(runs[i]);
+    return median(m);
+}
+
+// One bootstrap draw of run_median: resample the runs, then the repetitions within each drawn run
+static double resample(const Runs& runs, std::vector<double>& scratch) {
+    std::vector<double> m(runs.size());
+    for (size_t i = 0; i < m.size(); i++) {
+        const std::vector<double>& run = runs[rand_index(runs.size())];
+        scratch.resize(run.size());
+        for (size_t j = 0; j < run.size(); j++) scratch[j] = run[rand_index(run.size())];
+        m[i] = median(scratch);
+    }
+    return median(m);
+}
+
+// CONFIDENCE percentile-bootstrap interval of run_median(current) / run_median(base)
+static void ratio_interval(const Runs& base, const Runs& current, double* lo, double* hi) {
+    std::vector<double> ratios(BOOTSTRAP_ROUNDS);
+    std::vector<double> scratch;
+    for (size_t r = 0; r < BOOTSTRAP_ROUNDS; r++) {
+        double b = resample(base, scratch);
+        ratios[r] = resample(current, scratch) / b;
+    }
+    std::sort(ratios.begin(), ratios.end());
+    *lo = ratios[(size_t)((1 - CONFIDENCE) / 2 * (BOOTSTRAP_ROUNDS - 1))];
+    *hi = ratios[(size_t)((1 + CONFIDENCE) / 2 * (BOOTSTRAP_ROUNDS - 1))];
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: compare [--threshold percent] [--min-runs n] [--match substring]...\n"
+                         "               --base baseline.json... --current current.json...\n");
+}
+
+int main(int argc, char** argv) {
+    double threshold = 5.0;
+    long min_runs = 5;
+    std::vector<const char*> matches;
+    std::vector<const char*> base_files, current_files;
+    std::vector<const char*>* files = NULL;  // List the bare arguments go to
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--min-runs") == 0 && i + 1 < argc) {
+            min_runs = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--match") == 0 && i + 1 < argc) {
+            matches.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "--base") == 0) {
+            files = &base_files;
+        } else if (strcmp(argv[i], "--current") == 0) {
+            files = &current_files;
+        } else if (argv[i][0] == '-' || !files) {
+            usage();
+            return 2;
+        } else {
+            files->push_back(argv[i]);
+        }
+    }
+    if (base_files.empty() || current_files.empty() || threshold < 0 || min_runs < 1) {
+        usage();
+        return 2;
+    }
+
+    std::map<std::string, Runs> base, current;
+    for (const char* path : base_files) {
+        if (!load_results(path, base)) return 2;
+    }
+    for (const char* path : current_files) {
+        if (!load_results(path, current)) return 2;
+    }
+
+    auto wanted = [&matches](const std::string& name) {
+        if (matches.empty()) return true;
+        for (const char* m : matches) {
+            if (name.find(m) != std::string::npos) return true;
+        }
+        return false;
+    };
+
+    std::printf("%-34s %10s %10s %8s %18s  %s\n", "case", "base ns", "new ns", "change", "99% interval", "verdict");
+    size_t regressions = 0, compared = 0, missing = 0;
+    for (const auto& entry : base) {
+        const std::string& name = entry.first;
+        if (!wanted(name)) continue;
+        auto it = current.find(name);
+        if (it == current.end()) {
+            std::printf("%-34s %10.2f %10s %8s %18s  %s\n", name.c_str(), run_median(entry.second), "-", "", "",
+                        "MISSING from current run");
+            missing++;
+            continue;
+        }
+
+        double b = run_median(entry.second), c = run_median(it->second);
+        double change = (c / b - 1) * 100;
+        if (entry.second.size() < (size_t)min_runs || it->second.size() < (size_t)min_runs) {
+            // Too few independent runs to tell a shift from process-to-process noise
+            char verdict[64];
+            std::snprintf(verdict, sizeof(verdict), "too few runs (%zu/%zu, need %ld)", entry.second.size(),
+                          it->second.size(), min_runs);
+            std::printf("%-34s %10.2f %10.2f %+7.1f%% %18s  %s\n", name.c_str(), b, c, change, "", verdict);
+            continue;
+        }
+        double lo, hi;
+        ratio_interval(entry.second, it->second, &lo, &hi);
+        const char* verdict = "ok";
+        if (change > threshold) {
+            verdict = lo > 1 ? "REGRESSION" : "slower (within noise)";
+            if (lo > 1) regressions++;
+        } else if (change < -threshold) {
+            verdict = hi < 1 ? "improved" : "faster (within noise)";
+        }
+        char interval[48];
+        std::snprintf(interval, sizeof(interval), "[%+.1f%%, %+.1f%%]", (lo - 1) * 100, (hi - 1) * 100);
+        std::printf("%-34s %10.2f %10.2f %+7.1f%% %18s  %s\n", name.c_str(), b, c, change, interval, verdict);
+        compared++;
+    }
+    for (const auto& entry : current) {
+        if (wanted(entry.first) && base.find(entry.first) == base.end()) {
+            std::printf("%-34s %10s %10.2f %8s %18s  %s\n", entry.first.c_str(), "-", run_median(entry.second), "",
+                        "", "not in baseline");
+        }
+    }
+
+    std::printf("\n%zu compared, %zu regression%s beyond %.1f%%, %zu missing\n", compared, regressions,
+                regressions == 1 ? "" : "s", threshold, missing);
+    if (compared == 0) {
+        // Nothing was checked (no --match hit, or too few runs everywhere); don't pass a gate silently
+        std::fprintf(stderr, "compare: no case was compared\n");
+        return 2;
+    }
+    return regressions || missing ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// Allocation scalability from 1 to N threads: a mutex-wrapped Arena vs. the lock-free ConcurrentArena
+// vs. per-thread ArenaTlab buffers carved from a ConcurrentArena.
+//
+// Build: g++ -O2 -std=c++17 -pthread cpp/bench/concurrent.cpp cpp/arena.cpp cpp/concurrent_arena.cpp -o concurrent
+// Usage: ./concurrent [max_threads]   (default: hardware concurrency)
+
+#include "../arena.h"
+#include "../concurrent_arena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Allocations per thread per run
+#define OPS_PER_THREAD (2 * 1000 * 1000)
+
+// Arena guarded by one mutex, the way callers had to share it before
+struct LockedArena {
+    Arena arena;
+    std::mutex lock;
+
+    LockedArena() : arena(ARENA_DEFAULT_SIZE) {}
+
+    void* a_alloc(size_t bytes) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        return this->arena.a_alloc(bytes);
+    }
+};
+
+// Run OPS_PER_THREAD 32-byte allocations on each of `threads` threads; returns total Mops/s
+template <typename A>
+static double run(A& arena, unsigned threads) {
+    std::vector<std::thread> workers;
+    std::atomic<uintptr_t> sink(0);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&arena, &sink]() {
+            uintptr_t local = 0;
+            for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+                local += (uintptr_t)arena.a_alloc(32);
+            }
+            sink.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+    return (double)threads * OPS_PER_THREAD / secs / 1e6;
+}
+
+// Same workload with each thread allocating through its own ArenaTlab on the shared arena
+static double run_tlab(ConcurrentArena& arena, unsigned threads) {
+    std::vector<std::thread> workers;
+    std::atomic<uintptr_t> sink(0);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&arena, &sink]() {
+            ArenaTlab tlab(arena);
+            uintptr_t local = 0;
+            for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+                local += (uintptr_t)tlab.a_alloc(32);
+            }
+            sink.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+    return (double)threads * OPS_PER_THREAD / secs / 1e6;
+}
+
+int main(int argc, char** argv) {
+    unsigned max_threads = argc > 1 ? (unsigned)atoi(argv[1]) : std::thread::hardware_concurrency();
+    if (max_threads == 0) max_threads = 1;
+
+    std::printf("%7s %16s %16s %16s\n", "threads", "mutex Mops/s", "atomic Mops/s", "tlab Mops/s");
+    // Powers of two, then max_threads itself if it isn't one
+    for (unsigned threads = 1; threads <= max_threads;
+         threads = threads < max_threads && threads * 2 > max_threads ? max_threads : threads * 2) {
+        LockedArena locked;
+        ConcurrentArena shared(ARENA_DEFAULT_SIZE);
+        ConcurrentArena parent(ARENA_DEFAULT_SIZE);
+        double m = run(locked, threads);
+        double c = run(shared, threads);
+        double t = run_tlab(parent, threads);
+        std::printf("%7u %16.1f %16.1f %16.1f\n", threads, m, c, t);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+// Scoped lookup tables: ArenaHashMap inside a marker scope vs. std::unordered_map on the heap.
+// Each round fills a table, runs lookups (half of them misses), then drops it.
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/hash_map.cpp cpp/arena.cpp -o hash_map
+
+#include "../arena.h"
+#include "../arena_hash_map.h"
+
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+
+#define ROUNDS 50
+#define KEYS 100000
+
+// Fill `map`, then look up twice as many keys; `contains` adapts the lookup to each map's API
+template <typename Map, typename Contains>
+static size_t workload(Map& map, Contains contains) {
+    size_t hits = 0;
+    for (uint64_t i = 0; i < KEYS; i++) {
+        map[i * 2654435761u] = i;
+    }
+    for (uint64_t i = 0; i < 2 * KEYS; i++) {
+        hits += contains(map, i * 2654435761u);
+    }
+    return hits;
+}
+
+int main(void) {
+    size_t sink = 0;
+    Arena arena(ARENA_DEFAULT_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        arena.push_marker();
+        ArenaHashMap<uint64_t, uint64_t> map(arena);
+        sink += workload(map, [](ArenaHashMap<uint64_t, uint64_t>& m, uint64_t k) { return m.contains(k); });
+        arena.pop_marker();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double a = std::chrono::duration<double, std::milli>(stop - start).count() / ROUNDS;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        std::unordered_map<uint64_t, uint64_t> map;
+        sink += workload(map, [](std::unordered_map<uint64_t, uint64_t>& m, uint64_t k) { return m.count(k) != 0; });
+    }
+    stop = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double, std::milli>(stop - start).count() / ROUNDS;
+
+    if (sink == 1) std::puts("");  // Keep the work observable
+    std::printf("ArenaHashMap:        %8.2f ms/round\n", a);
+    std::printf("std::unordered_map:  %8.2f ms/round\n", s);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+// Pointer-chasing over a large arena-allocated graph, with and without huge page backed blocks.
+// Reports time per hop and dTLB load misses (via perf_event_open, when the kernel allows it).
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/huge_pages.cpp cpp/arena.cpp -o huge_pages
+// Usage: ./huge_pages [megabytes]   (default 256, at least one huge page)
+
+#include "../arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct Node {
+    Node* next;
+    uint64_t payload[7];  // One cache line per node
+};
+
+// dTLB read-miss counter for this thread; fd is -1 when perf events are unavailable
+struct TlbCounter {
+    int fd;
+
+    TlbCounter() : fd(-1) {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~TlbCounter() {
+#if defined(__linux__)
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop() {
+#if defined(__linux__)
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+};
+
+static void run(bool huge, size_t megabytes) {
+    // Small root so nearly everything lands in chained blocks
+    Arena arena(4096);
+    arena.set_huge_pages(huge);
+
+    size_t count = megabytes * 1024 * 1024 / sizeof(Node);
+    std::vector<Node*> nodes(count);
+    for (size_t i = 0; i < count; i++) {
+        nodes[i] = arena.make<Node>();
+    }
+
+    // Link the nodes into one random cycle so every hop is a likely TLB miss
+    std::mt19937_64 rng(42);
+    std::shuffle(nodes.begin(), nodes.end(), rng);
+    for (size_t i = 0; i < count; i++) {
+        nodes[i]->next = nodes[(i + 1) % count];
+    }
+
+    const size_t hops = 20 * 1000 * 1000;
+    Node* cur = nodes[0];
+    TlbCounter tlb;
+    tlb.start();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < hops; i++) {
+        cur = cur->next;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    long long misses = tlb.stop();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / (double)hops;
+    std::printf("%-11s %4zu MB: %7.2f ns/hop", huge ? "huge pages" : "base pages", megabytes, ns);
+    if (misses >= 0) {
+        std::printf(", dTLB misses %.3f/hop", (double)misses / (double)hops);
+    } else {
+        std::printf(", dTLB misses n/a");
+    }
+    std::printf("\n");
+    if (cur == NULL) std::puts("");  // Keep the traversal observable
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 256;
+    // At least one huge page, or there is nothing to compare (and no node to start the chase at)
+    if (megabytes < ARENA_HUGE_PAGE_SIZE / (1024 * 1024) || megabytes > SIZE_MAX / (1024 * 1024)) {
+        std::fprintf(stderr, "usage: huge_pages [megabytes]   (at least %d)\n", ARENA_HUGE_PAGE_SIZE / (1024 * 1024));
+        return EXIT_FAILURE;
+    }
+    run(false, megabytes);
+    run(true, megabytes);
+    return EXIT_SUCCESS;
+}
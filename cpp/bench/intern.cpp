@@ -0,0 +1,47 @@
+// Repeated identifiers: Arena::strdup of every occurrence vs. ArenaIntern. Reports time per token
+// and the arena footprint each approach ends up with.
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/intern.cpp cpp/arena.cpp cpp/arena_intern.cpp -o intern
+
+#include "../arena.h"
+#include "../arena_intern.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define TOKENS (2 * 1000 * 1000)
+#define DISTINCT 5000
+
+int main(void) {
+    std::vector<std::string> input;
+    input.reserve(TOKENS);
+    for (size_t i = 0; i < TOKENS; i++) {
+        input.push_back("identifier_" + std::to_string((i * 2654435761u) % DISTINCT));
+    }
+    size_t sink = 0;
+
+    Arena copies(ARENA_DEFAULT_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& token : input) {
+        sink += (uintptr_t)copies.strdup(token.c_str());
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double dup_ns = std::chrono::duration<double, std::nano>(stop - start).count() / TOKENS;
+
+    Arena interned(ARENA_DEFAULT_SIZE);
+    ArenaIntern table(interned);
+    start = std::chrono::steady_clock::now();
+    for (const std::string& token : input) {
+        sink += (uintptr_t)table.intern(token.data(), token.size());
+    }
+    stop = std::chrono::steady_clock::now();
+    double intern_ns = std::chrono::duration<double, std::nano>(stop - start).count() / TOKENS;
+
+    if (sink == 1) std::puts("");  // Keep the work observable
+    std::printf("strdup:  %6.1f ns/token, footprint %8zu KB\n", dup_ns, copies.footprint() / 1024);
+    std::printf("intern:  %6.1f ns/token, footprint %8zu KB (%zu distinct)\n", intern_ns,
+                interned.footprint() / 1024, table.size());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,413 @@
+// Whole-workload benchmarks where locality matters: building and checking a compiler-style AST
+// under nested markers, tokenizing a log with strdup, and a request loop that pushes and pops a
+// marker per request. Each runs on Arena and on malloc/free (freeing back to the same scope
+// boundaries) and reports throughput, peak RSS growth and per-unit latency percentiles.
+// c/bench/macro.c runs the same workloads, with the same random streams, on Arena_t.
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/macro.cpp cpp/arena.cpp -o macro
+// Usage: ./macro [log_megabytes]   (default 32, at least 1)
+
+#include "../arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+// Keeps results observable so the measured work isn't optimized away
+static uintptr_t sink;
+
+// xorshift64*: the same stream as c/bench/macro.c for a given seed
+static uint64_t rng_state;
+
+static uint64_t next_rand() {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+// Uniform in [lo, hi]
+static size_t rand_range(size_t lo, size_t hi) {
+    return lo + (size_t)(next_rand() % (hi - lo + 1));
+}
+
+// Current or peak resident set size in KB from /proc/self/status (`field` is "VmRSS:" or
+// "VmHWM:"); falls back to getrusage's process-wide peak where /proc is unavailable
+static long rss_kb(const char* field) {
+    FILE* f = std::fopen("/proc/self/status", "r");
+    if (f) {
+        char line[256];
+        size_t len = strlen(field);
+        while (std::fgets(line, sizeof(line), f)) {
+            if (strncmp(line, field, len) == 0) {
+                std::fclose(f);
+                return strtol(line + len, NULL, 10);
+            }
+        }
+        std::fclose(f);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Reset the kernel's peak RSS to the current RSS (Linux 4.0+) so each run reports its own peak
+static void reset_peak_rss() {
+    FILE* f = std::fopen("/proc/self/clear_refs", "w");
+    if (!f) return;
+    std::fputs("5", f);
+    std::fclose(f);
+}
+
+// Wall time of each unit of work (function, log batch, request)
+struct Latencies {
+    std::vector<double> ns;
+
+    void add(std::chrono::steady_clock::time_point start) {
+        ns.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // 0 when nothing was recorded
+    double percentile(double p) {
+        if (ns.empty()) return 0;
+        size_t i = (size_t)(p / 100.0 * (double)(ns.size() - 1));
+        std::nth_element(ns.begin(), ns.begin() + (long)i, ns.end());
+        return ns[i];
+    }
+};
+
+// Allocation through an Arena: scopes are markers
+struct ArenaAlloc {
+    Arena arena;
+
+    ArenaAlloc() : arena(ARENA_DEFAULT_SIZE) {}
+    void* alloc(size_t bytes) { return this->arena.a_alloc(bytes); }
+    char* strdup(const char* str) { return this->arena.strdup(str); }
+    void* realloc(void* ptr, size_t old_size, size_t new_size) { return this->arena.a_realloc(ptr, old_size, new_size); }
+    void push() { this->arena.push_marker(); }
+    void pop() { this->arena.pop_marker(); }
+};
+
+// Allocation through malloc: every block is tracked so a scope frees exactly what it allocated,
+// the way per-object ownership would
+struct MallocAlloc {
+    std::vector<void*> live;
+    std::vector<size_t> scopes;
+
+    ~MallocAlloc() {
+        for (void* p : this->live) free(p);
+    }
+
+    void* alloc(size_t bytes) {
+        void* p = malloc(bytes);
+        this->live.push_back(p);
+        return p;
+    }
+
+    char* strdup(const char* str) {
+        char* p = ::strdup(str);
+        this->live.push_back(p);
+        return p;
+    }
+
+    // The resized block is nearly always among the newest
+    void* realloc(void* ptr, size_t old_size, size_t new_size) {
+        (void)old_size;
+        void* p = ::realloc(ptr, new_size);
+        for (size_t i = this->live.size(); i-- > 0;) {
+            if (this->live[i] == ptr) {
+                this->live[i] = p;
+                break;
+            }
+        }
+        return p;
+    }
+
+    void push() { this->scopes.push_back(this->live.size()); }
+
+    void pop() {
+        size_t mark = this->scopes.back();
+        this->scopes.pop_back();
+        while (this->live.size() > mark) {
+            free(this->live.back());
+            this->live.pop_back();
+        }
+    }
+};
+
+static void report(const char* workload, const char* impl, double units, const char* unit, double secs,
+                   long rss_kb_growth, Latencies& lat) {
+    std::printf("%-9s %-7s %10.2f %-8s %8.1f MB %9.2f %9.2f %9.2f %9.2f\n", workload, impl,
+                units / secs / 1e6, unit, (double)rss_kb_growth / 1024.0, lat.percentile(50) / 1e3,
+                lat.percentile(99) / 1e3, lat.percentile(99.9) / 1e3, lat.percentile(100) / 1e3);
+}
+
+// AST workload: modules of functions whose statements are random expression trees. Each function
+// is checked in a scratch scope with a nested scope per statement; the module's trees stay live
+// until a final pass over the whole module
+
+#define AST_MODULES 40
+#define AST_FUNCTIONS 200
+#define AST_STATEMENTS 8
+#define AST_MAX_DEPTH 7
+
+enum { NODE_NUMBER, NODE_IDENT, NODE_BINARY };
+
+struct Node {
+    int kind;
+    int value;
+    const char* name;
+    Node* left;
+    Node* right;
+};
+
+// Scratch symbol-table entry made while checking
+struct Symbol {
+    const char* name;
+    Symbol* next;
+};
+
+template <typename A>
+static Node* build_expr(A& a, int depth, size_t* nodes) {
+    Node* n = (Node*)a.alloc(sizeof(Node));
+    (*nodes)++;
+    if (depth >= AST_MAX_DEPTH || rand_range(0, 3) == 0) {
+        if (rand_range(0, 1)) {
+            char name[24];
+            std::snprintf(name, sizeof(name), "var_%zu", rand_range(0, 999));
+            n->kind = NODE_IDENT;
+            n->name = a.strdup(name);
+        } else {
+            n->kind = NODE_NUMBER;
+            n->value = (int)rand_range(0, 100);
+            n->name = NULL;
+        }
+        n->left = n->right = NULL;
+        return n;
+    }
+    n->kind = NODE_BINARY;
+    n->value = (int)rand_range(0, 3);  // Operator
+    n->name = NULL;
+    n->left = build_expr(a, depth + 1, nodes);
+    n->right = build_expr(a, depth + 1, nodes);
+    return n;
+}
+
+// Resolve identifiers into a scratch table (16 buckets)
+template <typename A>
+static void check_expr(A& a, const Node* n, Symbol** table) {
+    if (n->kind == NODE_IDENT) {
+        size_t h = (size_t)(unsigned char)n->name[4] % 16;
+        Symbol* s = (Symbol*)a.alloc(sizeof(Symbol));
+        s->name = n->name;
+        s->next = table[h];
+        table[h] = s;
+    } else if (n->kind == NODE_BINARY) {
+        check_expr(a, n->left, table);
+        check_expr(a, n->right, table);
+    }
+}
+
+static long eval_expr(const Node* n) {
+    switch (n->kind) {
+        case NODE_NUMBER: return n->value;
+        case NODE_IDENT: return (long)n->name[4];
+        default: {
+            long l = eval_expr(n->left), r = eval_expr(n->right);
+            return n->value == 0 ? l + r : n->value == 1 ? l - r : n->value == 2 ? l ^ r : l | r;
+        }
+    }
+}
+
+template <typename A>
+static void run_ast(const char* impl) {
+    rng_state = 0x9E3779B97F4A7C15ULL;
+    reset_peak_rss();
+    long rss_start = rss_kb("VmRSS:");
+    Latencies lat;
+    size_t nodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+        A a;
+        std::vector<Node*> roots(AST_FUNCTIONS * AST_STATEMENTS);
+        for (size_t m = 0; m < AST_MODULES; m++) {
+            a.push();  // Module scope
+            for (size_t f = 0; f < AST_FUNCTIONS; f++) {
+                auto t = std::chrono::steady_clock::now();
+                for (size_t s = 0; s < AST_STATEMENTS; s++) {
+                    roots[f * AST_STATEMENTS + s] = build_expr(a, 0, &nodes);
+                }
+                a.push();  // Check scope
+                Symbol** table = (Symbol**)a.alloc(16 * sizeof(Symbol*));
+                memset(table, 0, 16 * sizeof(Symbol*));
+                for (size_t s = 0; s < AST_STATEMENTS; s++) {
+                    a.push();  // Statement scope
+                    Symbol* local[16] = {NULL};
+                    check_expr(a, roots[f * AST_STATEMENTS + s], local);
+                    for (size_t b = 0; b < 16; b++) sink += (uintptr_t)local[b];
+                    a.pop();
+                }
+                check_expr(a, roots[f * AST_STATEMENTS], table);
+                sink += (uintptr_t)table[0];
+                a.pop();
+                lat.add(t);
+            }
+            for (Node* root : roots) sink += (uintptr_t)eval_expr(root);
+            a.pop();
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("ast", impl, (double)nodes, "Mnodes/s", secs, rss_kb("VmHWM:") - rss_start, lat);
+}
+
+// Log workload: lines are tokenized in batches; each line is copied, split on spaces and every
+// token duplicated with strdup into the batch's scope
+
+#define LOG_BATCH 256
+#define LOG_MAX_TOKENS 16
+
+// Synthetic access log of about `bytes` bytes, one line per request
+static std::string make_log(size_t bytes) {
+    static const char* levels[] = {"INFO", "INFO", "INFO", "WARN", "ERROR", "DEBUG"};
+    static const char* paths[] = {"/api/v1/items", "/api/v1/users", "/static/app.js", "/healthz", "/api/v2/search"};
+    rng_state = 0xD1B54A32D192ED03ULL;
+    std::string log;
+    log.reserve(bytes + 256);
+    char line[256];
+    while (log.size() < bytes) {
+        // Drawn into locals first: argument evaluation order is unspecified
+        size_t day = rand_range(1, 28), hour = rand_range(0, 23), min = rand_range(0, 59);
+        size_t sec = rand_range(0, 59), ms = rand_range(0, 999);
+        const char* level = levels[rand_range(0, 5)];
+        size_t worker = rand_range(1, 32);
+        size_t id = (size_t)(next_rand() & 0xFFFFFFFF);
+        const char* path = paths[rand_range(0, 4)];
+        size_t item = rand_range(1, 99999);
+        size_t status = rand_range(0, 9) ? (size_t)200 : rand_range(400, 503);
+        size_t latency = rand_range(1, 2000);
+        size_t body = rand_range(0, 1 << 20);
+        int len = std::snprintf(line, sizeof(line),
+                                "2024-05-%02zuT%02zu:%02zu:%02zu.%03zuZ %s [worker-%zu] request id=%08zx "
+                                "path=%s/%zu status=%zu latency_ms=%zu bytes=%zu\n",
+                                day, hour, min, sec, ms, level, worker, id, path, item, status, latency, body);
+        log.append(line, (size_t)len);
+    }
+    return log;
+}
+
+template <typename A>
+static void run_log(const char* impl, const std::string& log) {
+    reset_peak_rss();
+    long rss_start = rss_kb("VmRSS:");
+    Latencies lat;
+    auto start = std::chrono::steady_clock::now();
+    {
+        A a;
+        const char* p = log.data();
+        const char* end = p + log.size();
+        while (p < end) {
+            auto t = std::chrono::steady_clock::now();
+            a.push();
+            for (size_t l = 0; l < LOG_BATCH && p < end; l++) {
+                const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+                if (!eol) eol = end;
+                size_t len = (size_t)(eol - p);
+                char* copy = (char*)a.alloc(len + 1);
+                memcpy(copy, p, len);
+                copy[len] = '\0';
+                char** tokens = (char**)a.alloc(LOG_MAX_TOKENS * sizeof(char*));
+                size_t count = 0;
+                for (char* tok = copy; *tok && count < LOG_MAX_TOKENS;) {
+                    char* space = strchr(tok, ' ');
+                    if (space) *space = '\0';
+                    tokens[count++] = a.strdup(tok);
+                    if (!space) break;
+                    tok = space + 1;
+                }
+                if (count > 6 && tokens[6][7] == '5') sink++;  // status=5xx
+                sink += count;
+                p = eol + 1;
+            }
+            a.pop();
+            lat.add(t);
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("log", impl, (double)log.size(), "MB/s", secs, rss_kb("VmHWM:") - rss_start, lat);
+}
+
+// Request workload: each request gets its own scope for parsed headers, request objects and a
+// response buffer grown by appending; one in a thousand also needs a large scratch buffer
+
+#define REQUESTS 200000
+
+template <typename A>
+static void run_requests(const char* impl) {
+    static const char* headers[] = {"Host: example.com", "Accept: application/json", "User-Agent: bench/1.0",
+                                    "Accept-Encoding: gzip, deflate, br", "Cookie: session=0123456789abcdef",
+                                    "X-Request-Id: 7f9c2ba4e88f827d616045507605853e"};
+    rng_state = 0xBF58476D1CE4E5B9ULL;
+    reset_peak_rss();
+    long rss_start = rss_kb("VmRSS:");
+    Latencies lat;
+    auto start = std::chrono::steady_clock::now();
+    {
+        A a;
+        for (size_t r = 0; r < REQUESTS; r++) {
+            auto t = std::chrono::steady_clock::now();
+            a.push();
+            size_t count = rand_range(10, 30);
+            for (size_t h = 0; h < count; h++) sink += (uintptr_t)a.strdup(headers[h % 6]);
+            for (size_t o = 0; o < 8; o++) {
+                size_t size = rand_range(64, 4096);
+                char* obj = (char*)a.alloc(size);
+                obj[0] = obj[size - 1] = 1;
+            }
+            size_t cap = 256, used = 0, target = rand_range(1024, 32 * 1024);
+            char* body = (char*)a.alloc(cap);
+            while (used < target) {
+                size_t chunk = rand_range(64, 512);
+                while (used + chunk > cap) {
+                    body = (char*)a.realloc(body, cap, cap * 2);
+                    cap *= 2;
+                }
+                memset(body + used, 'x', chunk);
+                used += chunk;
+            }
+            sink += (uintptr_t)body[used / 2];
+            if (rand_range(0, 999) == 0) {
+                char* big = (char*)a.alloc(512 * 1024);
+                memset(big, 0, 512 * 1024);
+            }
+            a.pop();
+            lat.add(t);
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("requests", impl, (double)REQUESTS, "Mreq/s", secs, rss_kb("VmHWM:") - rss_start, lat);
+}
+
+int main(int argc, char** argv) {
+    size_t log_mb = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 32;
+    if (log_mb == 0 || log_mb > SIZE_MAX / (1024 * 1024)) {
+        std::fprintf(stderr, "usage: macro [log_megabytes]   (at least 1)\n");
+        return EXIT_FAILURE;
+    }
+    std::string log = make_log(log_mb * 1024 * 1024);
+
+    std::printf("%-9s %-7s %19s %11s %9s %9s %9s %9s\n", "workload", "alloc", "throughput", "peak RSS",
+                "p50 us", "p99 us", "p99.9 us", "max us");
+    run_ast<ArenaAlloc>("arena");
+    run_ast<MallocAlloc>("malloc");
+    run_log<ArenaAlloc>("arena", log);
+    run_log<MallocAlloc>("malloc", log);
+    run_requests<ArenaAlloc>("arena");
+    run_requests<MallocAlloc>("malloc");
+    if (sink == 1) std::puts("");
+    return EXIT_SUCCESS;
+}
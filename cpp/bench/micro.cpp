@@ -0,0 +1,431 @@
+// Per-operation cost of the Arena API against malloc/free and std::pmr::monotonic_buffer_resource:
+// small and large allocation, calloc, tail and non-tail realloc, strdup, marker scopes spanning
+// chains of 1-5 blocks, and reset of a chained arena. Reports ns/op plus cycles, cache misses and
+// page faults per op (perf_event_open; faults fall back to getrusage, the others print n/a).
+// With --json, prints every repetition's ns/op as JSON for cpp/bench/compare.cpp instead; compare
+// wants several such runs per side, each from its own process.
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/micro.cpp cpp/arena.cpp -o micro
+// Usage: ./micro [--json] [repetitions]   (default 1, or 10 with --json; the median is reported)
+
+#include "../arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+#include <sys/resource.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Allocations between resets (and between frees for malloc)
+#define BATCH 1024
+
+// One perf event counter for this thread; fd is -1 when perf events are unavailable
+struct PerfCounter {
+    int fd;
+
+    PerfCounter(uint32_t type, uint64_t config) : fd(-1) {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+
+    ~PerfCounter() {
+#if defined(__linux__)
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop() {
+#if defined(__linux__)
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+};
+
+// Minor plus major page faults of the process so far
+static long long rusage_faults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (long long)(usage.ru_minflt + usage.ru_majflt);
+}
+
+// Per-op results of one measurement; counters are negative when unavailable
+struct Sample {
+    double ns;
+    double cycles;
+    double misses;
+    double faults;
+};
+
+#if defined(__linux__)
+#define MICRO_CYCLES PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES
+#define MICRO_MISSES PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES
+#define MICRO_FAULTS PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS
+#else
+#define MICRO_CYCLES 0, 0
+#define MICRO_MISSES 0, 0
+#define MICRO_FAULTS 0, 0
+#endif
+
+// Keeps results observable so the measured work isn't optimized away
+static uintptr_t sink;
+
+// Run `body(ops)` under the counters
+template <typename Body>
+static Sample measure(size_t ops, Body& body) {
+    PerfCounter cycles(MICRO_CYCLES), misses(MICRO_MISSES), faults(MICRO_FAULTS);
+    long long faults_before = rusage_faults();
+    cycles.start();
+    misses.start();
+    faults.start();
+    auto start = std::chrono::steady_clock::now();
+    body(ops);
+    auto stop = std::chrono::steady_clock::now();
+    long long c = cycles.stop(), m = misses.stop(), f = faults.stop();
+    if (f < 0) f = rusage_faults() - faults_before;
+
+    Sample s;
+    s.ns = std::chrono::duration<double, std::nano>(stop - start).count() / (double)ops;
+    s.cycles = c >= 0 ? (double)c / (double)ops : -1;
+    s.misses = m >= 0 ? (double)m / (double)ops : -1;
+    s.faults = (double)f / (double)ops;
+    return s;
+}
+
+static void print_counter(double value) {
+    if (value >= 0) std::printf(" %12.3f", value);
+    else std::printf(" %12s", "n/a");
+}
+
+// Command-line settings
+static size_t repetitions = 1;
+static bool json = false;
+
+// Results printed so far (to separate JSON entries)
+static size_t result_count;
+
+// Print a case's samples as one entry of the JSON "results" array
+static void print_json(const char* name, const char* impl, const std::vector<Sample>& samples) {
+    std::printf("%s\n    {\"name\": \"%s/%s\", \"unit\": \"ns/op\", \"samples\": [", result_count ? "," : "",
+                name, impl);
+    for (size_t i = 0; i < samples.size(); i++) {
+        std::printf("%s%.4f", i ? ", " : "", samples[i].ns);
+    }
+    std::printf("]}");
+}
+
+// Warm caches and free lists with one untimed run, measure `repetitions` times, then print the
+// median sample as a table row (or all of them as JSON)
+template <typename Body>
+static void run(const char* name, const char* impl, size_t ops, Body body) {
+    body(ops);
+    std::vector<Sample> samples;
+    for (size_t r = 0; r < repetitions; r++) {
+        samples.push_back(measure(ops, body));
+    }
+    if (json) {
+        print_json(name, impl, samples);
+    } else {
+        std::vector<Sample> sorted = samples;
+        std::sort(sorted.begin(), sorted.end(), [](const Sample& a, const Sample& b) { return a.ns < b.ns; });
+        Sample s = sorted[sorted.size() / 2];
+        std::printf("%-24s %-10s %10.2f", name, impl, s.ns);
+        print_counter(s.cycles);
+        print_counter(s.misses);
+        print_counter(s.faults);
+        std::printf("\n");
+    }
+    result_count++;
+}
+
+// `size`-byte allocations, touching the first byte, dropped every BATCH
+static void bench_alloc(const char* name, size_t size, size_t ops) {
+    Arena arena(BATCH * size);
+    run(name, "arena", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            char* p = (char*)arena.a_alloc(size);
+            *p = 0;
+            sink += (uintptr_t)p;
+            if (i % BATCH == BATCH - 1) arena.reset();
+        }
+        arena.reset();
+    });
+
+    std::vector<void*> live(BATCH);
+    run(name, "malloc", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            char* p = (char*)malloc(size);
+            *p = 0;
+            live[i % BATCH] = p;
+            if (i % BATCH == BATCH - 1 || i == n - 1) {
+                for (size_t j = 0; j <= i % BATCH; j++) free(live[j]);
+            }
+        }
+    });
+
+    std::vector<uint8_t> buffer(BATCH * size);
+    std::pmr::monotonic_buffer_resource monotonic(buffer.data(), buffer.size());
+    run(name, "monotonic", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            char* p = (char*)monotonic.allocate(size, ARENA_ALIGNMENT);
+            *p = 0;
+            sink += (uintptr_t)p;
+            if (i % BATCH == BATCH - 1) monotonic.release();
+        }
+        monotonic.release();
+    });
+}
+
+// Zeroed 64-byte allocations
+static void bench_calloc(size_t ops) {
+    const size_t size = 64;
+    Arena arena(BATCH * size);
+    run("a_calloc 64 B", "arena", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            sink += (uintptr_t)arena.a_calloc(1, size);
+            if (i % BATCH == BATCH - 1) arena.reset();
+        }
+        arena.reset();
+    });
+
+    std::vector<void*> live(BATCH);
+    run("a_calloc 64 B", "malloc", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            live[i % BATCH] = calloc(1, size);
+            if (i % BATCH == BATCH - 1 || i == n - 1) {
+                for (size_t j = 0; j <= i % BATCH; j++) free(live[j]);
+            }
+        }
+    });
+
+    std::vector<uint8_t> buffer(BATCH * size);
+    std::pmr::monotonic_buffer_resource monotonic(buffer.data(), buffer.size());
+    run("a_calloc 64 B", "monotonic", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            void* p = monotonic.allocate(size, ARENA_ALIGNMENT);
+            memset(p, 0, size);
+            sink += (uintptr_t)p;
+            if (i % BATCH == BATCH - 1) monotonic.release();
+        }
+        monotonic.release();
+    });
+}
+
+// Grow a 256-byte buffer to 512; with `tail` false a spacer allocation sits after it so the
+// arena has to move it. The monotonic resource can't resize, so it always copies
+static void bench_realloc(bool tail, size_t ops) {
+    const char* name = tail ? "a_realloc tail" : "a_realloc non-tail";
+    const size_t per_op = 512 + 256 + 16;
+    Arena arena(BATCH * per_op);
+    run(name, "arena", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            void* p = arena.a_alloc(256);
+            if (!tail) arena.a_alloc(16);
+            sink += (uintptr_t)arena.a_realloc(p, 256, 512);
+            if (i % BATCH == BATCH - 1) arena.reset();
+        }
+        arena.reset();
+    });
+
+    std::vector<void*> live(2 * BATCH);
+    run(name, "malloc", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            void* p = malloc(256);
+            live[2 * (i % BATCH) + 1] = tail ? NULL : malloc(16);
+            live[2 * (i % BATCH)] = realloc(p, 512);
+            if (i % BATCH == BATCH - 1 || i == n - 1) {
+                for (size_t j = 0; j <= 2 * (i % BATCH) + 1; j++) free(live[j]);
+            }
+        }
+    });
+
+    std::vector<uint8_t> buffer(BATCH * per_op);
+    std::pmr::monotonic_buffer_resource monotonic(buffer.data(), buffer.size());
+    run(name, "monotonic", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            void* p = monotonic.allocate(256, ARENA_ALIGNMENT);
+            if (!tail) sink += (uintptr_t)monotonic.allocate(16, ARENA_ALIGNMENT);
+            void* q = monotonic.allocate(512, ARENA_ALIGNMENT);
+            memcpy(q, p, 256);
+            sink += (uintptr_t)q;
+            if (i % BATCH == BATCH - 1) monotonic.release();
+        }
+        monotonic.release();
+    });
+}
+
+// Copies of a 40-character identifier
+static void bench_strdup(size_t ops) {
+    const char* str = "a_reasonably_long_identifier_name_123456";
+    const size_t len = strlen(str) + 1;
+    Arena arena(BATCH * len);
+    run("strdup 40 chars", "arena", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            sink += (uintptr_t)arena.strdup(str);
+            if (i % BATCH == BATCH - 1) arena.reset();
+        }
+        arena.reset();
+    });
+
+    std::vector<char*> live(BATCH);
+    run("strdup 40 chars", "malloc", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            live[i % BATCH] = ::strdup(str);
+            if (i % BATCH == BATCH - 1 || i == n - 1) {
+                for (size_t j = 0; j <= i % BATCH; j++) free(live[j]);
+            }
+        }
+    });
+
+    std::vector<uint8_t> buffer(BATCH * len);
+    std::pmr::monotonic_buffer_resource monotonic(buffer.data(), buffer.size());
+    run("strdup 40 chars", "monotonic", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            char* dup = (char*)monotonic.allocate(len, 1);
+            memcpy(dup, str, len);
+            sink += (uintptr_t)dup;
+            if (i % BATCH == BATCH - 1) monotonic.release();
+        }
+        monotonic.release();
+    });
+}
+
+// A marker scope that chains `extra` blocks: chunks of 1, 2, 4, ... MB each fill a new block
+// exactly, so after the first round every pop hands them to the block cache and every push
+// takes them back. The baselines allocate and drop the same chunks
+static void bench_markers(size_t extra, size_t ops) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "push/pop %zu-block chain", extra + 1);
+
+    Arena arena(4096);
+    arena.push_marker();
+    for (size_t k = 0; k < extra; k++) arena.a_alloc((size_t)ARENA_DEFAULT_SIZE << k);
+    if (arena.stats().block_count != extra + 1) {
+        std::fprintf(stderr, "%s: chain came out at %zu blocks\n", name, arena.stats().block_count);
+    }
+    arena.pop_marker();
+    run(name, "arena", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            arena.push_marker();
+            for (size_t k = 0; k < extra; k++) sink += (uintptr_t)arena.a_alloc((size_t)ARENA_DEFAULT_SIZE << k);
+            arena.pop_marker();
+        }
+    });
+
+    if (extra == 0) return;  // Nothing to compare an empty scope with
+    std::vector<void*> live(extra);
+    run(name, "malloc", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = 0; k < extra; k++) live[k] = malloc((size_t)ARENA_DEFAULT_SIZE << k);
+            for (size_t k = 0; k < extra; k++) free(live[k]);
+        }
+    });
+
+    std::pmr::monotonic_buffer_resource monotonic(4096);
+    run(name, "monotonic", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = 0; k < extra; k++) {
+                sink += (uintptr_t)monotonic.allocate((size_t)ARENA_DEFAULT_SIZE << k, ARENA_ALIGNMENT);
+            }
+            monotonic.release();
+        }
+    });
+}
+
+// Fill a 64 KB root well past its end with 1 KB allocations, then drop everything; ns per reset
+static void bench_reset(size_t ops) {
+    const size_t size = 1024;
+    Arena arena(64 * 1024);
+    run("reset 1 MB chained", "arena", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < BATCH; j++) sink += (uintptr_t)arena.a_alloc(size);
+            arena.reset();
+        }
+    });
+
+    std::vector<void*> live(BATCH);
+    run("reset 1 MB chained", "malloc", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < BATCH; j++) live[j] = malloc(size);
+            for (size_t j = 0; j < BATCH; j++) free(live[j]);
+        }
+    });
+
+    std::pmr::monotonic_buffer_resource monotonic(64 * 1024);
+    run("reset 1 MB chained", "monotonic", ops, [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < BATCH; j++) sink += (uintptr_t)monotonic.allocate(size, ARENA_ALIGNMENT);
+            monotonic.release();
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    bool reps_given = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else {
+            repetitions = (size_t)strtoull(argv[i], NULL, 10);
+            reps_given = true;
+        }
+    }
+    if (!reps_given && json) repetitions = 10;
+    if (repetitions == 0) repetitions = 1;
+
+    if (json) {
+        std::printf("{\"benchmark\": \"micro\", \"repetitions\": %zu, \"results\": [", repetitions);
+    } else {
+        std::printf("%-24s %-10s %10s %12s %12s %12s\n", "operation", "allocator", "ns/op", "cycles/op",
+                    "misses/op", "faults/op");
+    }
+    bench_alloc("a_alloc 16 B", 16, 4 * 1024 * 1024);
+    bench_alloc("a_alloc 4 KB", 4096, 256 * 1024);
+    bench_calloc(2 * 1024 * 1024);
+    bench_realloc(true, 1024 * 1024);
+    bench_realloc(false, 1024 * 1024);
+    bench_strdup(2 * 1024 * 1024);
+    const size_t extras[] = {0, 1, 2, 4};
+    for (size_t extra : extras) {
+        bench_markers(extra, extra ? 2000 : 4 * 1024 * 1024);
+    }
+    bench_reset(2000);
+    if (json) std::printf("\n]}\n");
+    if (sink == 1) std::puts("");
+    return EXIT_SUCCESS;
+}
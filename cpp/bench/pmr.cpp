@@ -0,0 +1,73 @@
+// pmr containers on ArenaResource vs. std::pmr::monotonic_buffer_resource vs. the default heap.
+// Each round builds a vector, a string list and an unordered_map, then drops everything at once
+// (pop_marker for the arena, release() for the monotonic resource).
+//
+// Build: g++ -O2 -std=c++17 cpp/bench/pmr.cpp cpp/arena.cpp cpp/arena_resource.cpp -o pmr
+
+#include "../arena.h"
+#include "../arena_resource.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define ROUNDS 200
+#define ELEMENTS 20000
+
+// One round of container work on `res`; returns a checksum so the work stays observable
+static size_t workload(std::pmr::memory_resource* res) {
+    std::pmr::vector<int> numbers(res);
+    for (int i = 0; i < ELEMENTS; i++) {
+        numbers.push_back(i);
+    }
+
+    std::pmr::vector<std::pmr::string> names(res);
+    for (int i = 0; i < ELEMENTS / 4; i++) {
+        names.emplace_back("identifier_with_a_long_name_");  // Strings inherit the vector's resource
+        names.back() += std::to_string(i);
+    }
+
+    std::pmr::unordered_map<int, int> table(res);
+    for (int i = 0; i < ELEMENTS; i++) {
+        table[i * 7] = i;
+    }
+
+    return numbers.size() + names.back().size() + table.size();
+}
+
+// Time ROUNDS rounds; `reset` runs after each round to drop its memory
+template <typename Reset>
+static double run(std::pmr::memory_resource* res, Reset reset) {
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        sink += workload(res);
+        reset();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if (sink == 1) std::puts("");  // Keep the work observable
+    return std::chrono::duration<double, std::micro>(stop - start).count() / ROUNDS;
+}
+
+int main(void) {
+    Arena arena(ARENA_DEFAULT_SIZE);
+    ArenaResource arena_res(arena);
+    arena.push_marker();
+    double a = run(&arena_res, [&arena]() {
+        arena.pop_marker();
+        arena.push_marker();
+    });
+
+    std::pmr::monotonic_buffer_resource monotonic(ARENA_DEFAULT_SIZE);
+    double m = run(&monotonic, [&monotonic]() { monotonic.release(); });
+
+    double h = run(std::pmr::new_delete_resource(), []() {});
+
+    std::printf("ArenaResource:               %8.1f us/round\n", a);
+    std::printf("monotonic_buffer_resource:   %8.1f us/round\n", m);
+    std::printf("new_delete_resource:         %8.1f us/round\n", h);
+    return EXIT_SUCCESS;
+}
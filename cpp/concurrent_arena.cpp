@@ -0,0 +1,272 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "concurrent_arena.h"
+
+// Header size rounded to a cache line so the contended `used` counter doesn't share a line with data
+#define CONCURRENT_ARENA_HEADER ((sizeof(Block) + 63) & ~(size_t)63)
+
+// Allocate a block header plus `capacity` usable bytes
+ConcurrentArena::Block* ConcurrentArena::new_block(size_t capacity) {
+    uint8_t* mem = (uint8_t*)malloc(CONCURRENT_ARENA_HEADER + capacity);
+    if (!mem) return NULL;
+    Block* block = new (mem) Block;
+    block->next = NULL;
+    block->base = mem + CONCURRENT_ARENA_HEADER;
+    block->capacity = capacity;
+    block->used.store(0, std::memory_order_relaxed);
+    return block;
+}
+
+ConcurrentArena::ConcurrentArena (size_t initial_size) {
+    if (initial_size == 0) initial_size = ARENA_DEFAULT_SIZE;
+    initial_size = (initial_size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    this->initial_size = initial_size;
+
+    Block* block = new_block(initial_size);
+    if (!block) {
+        exit(EXIT_FAILURE);
+    }
+    this->current.store(block, std::memory_order_release);
+    this->epoch.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < ARENA_STAT_SHARDS; i++) {
+        this->shards[i].padding.store(0, std::memory_order_relaxed);
+        this->shards[i].tail_waste.store(0, std::memory_order_relaxed);
+    }
+    this->tail_waste.store(0, std::memory_order_relaxed);
+    this->growths.store(0, std::memory_order_relaxed);
+    this->mallocs.store(0, std::memory_order_relaxed);
+    this->peak.store(0, std::memory_order_relaxed);
+}
+
+ConcurrentArena::~ConcurrentArena() {
+    Block* cur = this->current.load(std::memory_order_acquire);
+    while (cur) {
+        Block* next = cur->next;
+        cur->~Block();
+        free(cur);
+        cur = next;
+    }
+}
+
+// Slow path: install a block twice the size of the full one, unless another thread beat us to it
+void* ConcurrentArena::grow(Block* full, size_t bytes, size_t wasted) {
+    for (;;) {
+        if (wasted) {
+            this->tail_waste.fetch_add(wasted, std::memory_order_relaxed);
+            wasted = 0;
+        }
+        Block* block = this->current.load(std::memory_order_acquire);
+        if (block != full) {
+            // Another thread already installed a new block: try it first
+            size_t offset = block->used.fetch_add(bytes, std::memory_order_relaxed);
+            if (offset <= block->capacity && bytes <= block->capacity - offset) {
+                return block->base + offset;
+            }
+            if (offset < block->capacity) wasted = block->capacity - offset;
+            full = block;
+            continue;
+        }
+
+        size_t capacity = full->capacity * 2;
+        if (capacity < this->initial_size) capacity = this->initial_size;
+        if (capacity < bytes) capacity = bytes;
+        Block* fresh = new_block(capacity);
+        if (!fresh) return NULL;
+        this->mallocs.fetch_add(1, std::memory_order_relaxed);
+        fresh->next = full;
+        fresh->used.store(bytes, std::memory_order_relaxed);  // Our slice is the first one
+
+        Block* expected = full;
+        if (this->current.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+            this->growths.fetch_add(1, std::memory_order_relaxed);
+            return fresh->base;
+        }
+        // Lost the race: drop our block and retry on the winner's
+        fresh->~Block();
+        free(fresh);
+    }
+}
+
+// Allocate aligned memory: claim an aligned slice of the current block with a CAS
+void* ConcurrentArena::a_alloc_aligned(size_t bytes, size_t align) {
+    if (bytes == 0 || align == 0 || (align & (align - 1)) != 0) return NULL;
+    if (bytes > CONCURRENT_ARENA_MAX_REQUEST || align > CONCURRENT_ARENA_MAX_REQUEST) return NULL;
+    if (align <= ARENA_ALIGNMENT) return a_alloc(bytes);
+    Shard& counters = shard();
+    size_t rounded = (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    counters.padding.fetch_add(rounded - bytes, std::memory_order_relaxed);
+    bytes = rounded;
+
+    Block* block = this->current.load(std::memory_order_acquire);
+    size_t offset = block->used.load(std::memory_order_relaxed);
+    for (;;) {
+        uintptr_t addr = ((uintptr_t)block->base + offset + align - 1) & ~(uintptr_t)(align - 1);
+        size_t start = (size_t)(addr - (uintptr_t)block->base);
+        if (start > block->capacity || bytes > block->capacity - start) break;
+        if (block->used.compare_exchange_weak(offset, start + bytes, std::memory_order_relaxed)) {
+            counters.padding.fetch_add(start - offset, std::memory_order_relaxed);
+            return (void*)addr;
+        }
+    }
+
+    // Doesn't fit: take a slice from the next block padded so it can be aligned inside. Once that
+    // block is installed the end of this one is never handed out, so close it with an overshooting
+    // fetch-add; if ours is the first to overshoot, the unclaimed end is ours to record as waste
+    size_t offset_now = block->used.fetch_add(block->capacity, std::memory_order_relaxed);
+    size_t wasted = offset_now < block->capacity ? block->capacity - offset_now : 0;
+    uint8_t* slice = (uint8_t*)grow(block, bytes + align - ARENA_ALIGNMENT, wasted);
+    if (!slice) return NULL;
+    uint8_t* ptr = (uint8_t*)(((uintptr_t)slice + align - 1) & ~(uintptr_t)(align - 1));
+    counters.padding.fetch_add(align - ARENA_ALIGNMENT, std::memory_order_relaxed);
+    return ptr;
+}
+
+// Duplicate a string into the arena
+char* ConcurrentArena::strdup(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str) + 1;
+    char* dup = (char*)a_alloc(len);
+    if (dup) memcpy(dup, str, len);
+    return dup;
+}
+
+// Keep the newest (largest) block and free the older ones
+void ConcurrentArena::reset() {
+    size_t now = used();
+    if (now > this->peak.load(std::memory_order_relaxed)) this->peak.store(now, std::memory_order_relaxed);
+    // Only the kept block survives, and it starts over empty
+    for (size_t i = 0; i < ARENA_STAT_SHARDS; i++) {
+        this->shards[i].padding.store(0, std::memory_order_relaxed);
+        this->shards[i].tail_waste.store(0, std::memory_order_relaxed);
+    }
+    this->tail_waste.store(0, std::memory_order_relaxed);
+    this->epoch.fetch_add(1, std::memory_order_relaxed);
+    Block* block = this->current.load(std::memory_order_acquire);
+    Block* n = block->next;
+    block->next = NULL;
+    block->used.store(0, std::memory_order_relaxed);
+    while (n) {
+        Block* temp = n->next;
+        n->~Block();
+        free(n);
+        n = temp;
+    }
+}
+
+// Bytes consumed in the chain: each block up to its capacity, minus the ends left behind by growth
+// and by thread-local buffers
+size_t ConcurrentArena::used() const {
+    size_t bytes = 0;
+    for (Block* block = this->current.load(std::memory_order_acquire); block; block = block->next) {
+        size_t claimed = block->used.load(std::memory_order_relaxed);
+        bytes += claimed < block->capacity ? claimed : block->capacity;
+    }
+    size_t tail = this->tail_waste.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < ARENA_STAT_SHARDS; i++) {
+        tail += this->shards[i].tail_waste.load(std::memory_order_relaxed);
+    }
+    return bytes > tail ? bytes - tail : 0;
+}
+
+ArenaStats ConcurrentArena::stats() {
+    ArenaStats s;
+    memset(&s, 0, sizeof(s));
+    for (size_t i = 0; i < ARENA_STAT_SHARDS; i++) {
+        s.padding_waste += this->shards[i].padding.load(std::memory_order_relaxed);
+        s.tail_waste += this->shards[i].tail_waste.load(std::memory_order_relaxed);
+    }
+    s.tail_waste += this->tail_waste.load(std::memory_order_relaxed);
+    for (Block* block = this->current.load(std::memory_order_acquire); block; block = block->next) {
+        s.bytes_committed += block->capacity;
+        s.block_count++;
+    }
+    s.bytes_used = used();
+    s.bytes_requested = s.bytes_used > s.padding_waste ? s.bytes_used - s.padding_waste : 0;
+    // Raise the shared peak unless a concurrent stats() call already raised it further
+    size_t peak = this->peak.load(std::memory_order_relaxed);
+    while (s.bytes_used > peak && !this->peak.compare_exchange_weak(peak, s.bytes_used, std::memory_order_relaxed)) {}
+    s.peak_used = s.bytes_used > peak ? s.bytes_used : peak;
+    s.growth_events = this->growths.load(std::memory_order_relaxed);
+    s.system_allocs = this->mallocs.load(std::memory_order_relaxed);
+    s.marker_depth = 0;
+    return s;
+}
+
+ArenaTlab::ArenaTlab (ConcurrentArena& parent, size_t chunk_size) {
+    this->parent = &parent;
+    this->bump = NULL;
+    this->end = NULL;
+    this->epoch = parent.epoch.load(std::memory_order_relaxed);
+    chunk_size = chunk_size ? chunk_size : ARENA_TLAB_CHUNK;
+    this->chunk_size = (chunk_size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    this->padding = 0;
+}
+
+ArenaTlab::~ArenaTlab() {
+    flush();
+    if (this->end && this->epoch == this->parent->epoch.load(std::memory_order_relaxed)) {
+        // The rest of the chunk is abandoned
+        this->parent->shard().tail_waste.fetch_add((size_t)(this->end - this->bump), std::memory_order_relaxed);
+    }
+}
+
+void ArenaTlab::flush() {
+    if (this->padding && this->epoch == this->parent->epoch.load(std::memory_order_relaxed)) {
+        this->parent->shard().padding.fetch_add(this->padding, std::memory_order_relaxed);
+    }
+    this->padding = 0;
+}
+
+// Slow path: the chunk is exhausted or predates a reset of the parent
+void* ArenaTlab::refill(size_t bytes, size_t align) {
+    if (bytes > CONCURRENT_ARENA_MAX_REQUEST) return NULL;  // Keeps the padded size below from wrapping
+    flush();
+    uint64_t epoch = this->parent->epoch.load(std::memory_order_relaxed);
+    if (epoch != this->epoch) {
+        // The parent was reset: the old chunk is gone
+        this->epoch = epoch;
+        this->bump = NULL;
+        this->end = NULL;
+    }
+    size_t padded = bytes + (align > ARENA_ALIGNMENT ? align - ARENA_ALIGNMENT : 0);
+    if (padded > this->chunk_size / 4) {
+        // Large requests go straight to the parent instead of wasting most of a chunk
+        return this->parent->a_alloc_aligned(bytes, align);
+    }
+    uint8_t* chunk = (uint8_t*)this->parent->a_alloc(this->chunk_size);
+    if (!chunk) return NULL;
+    if (this->end) {
+        // The rest of the old chunk is abandoned
+        this->parent->shard().tail_waste.fetch_add((size_t)(this->end - this->bump), std::memory_order_relaxed);
+    }
+    this->end = chunk + this->chunk_size;
+    uint8_t* ptr = (uint8_t*)(((uintptr_t)chunk + align - 1) & ~(uintptr_t)(align - 1));
+    this->padding += (size_t)(ptr - chunk);
+    this->bump = ptr + bytes;
+    return ptr;
+}
+
+// Allocate aligned memory from the private chunk
+void* ArenaTlab::a_alloc_aligned(size_t bytes, size_t align) {
+    if (bytes == 0 || align == 0 || (align & (align - 1)) != 0) return NULL;
+    uint8_t* ptr = (uint8_t*)(((uintptr_t)this->bump + align - 1) & ~(uintptr_t)(align - 1));
+    if (ptr <= this->end && bytes <= (size_t)(this->end - ptr) &&
+        this->epoch == this->parent->epoch.load(std::memory_order_relaxed)) {
+        this->padding += (size_t)(ptr - this->bump);
+        this->bump = ptr + bytes;
+        return ptr;
+    }
+    return refill(bytes, align);
+}
+
+// Duplicate a string into the buffer
+char* ArenaTlab::strdup(const char* str) {
+    if (!str) return NULL;
+    size_t len = strlen(str) + 1;
+    char* dup = (char*)a_alloc_aligned(len, 1);
+    if (dup) memcpy(dup, str, len);
+    return dup;
+}
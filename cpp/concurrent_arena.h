@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "arena.h"
+
+#ifndef CONCURRENT_ARENA_H
+#define CONCURRENT_ARENA_H
+
+// Default chunk a thread-local allocation buffer grabs from its parent at a time
+#define ARENA_TLAB_CHUNK (64 * 1024)
+
+// Statistics counter shards per ConcurrentArena; threads are spread over them round-robin
+#define ARENA_STAT_SHARDS 16
+
+// Largest request a ConcurrentArena serves, so a block's shared offset can't wrap even when many
+// threads overshoot it at once
+#define CONCURRENT_ARENA_MAX_REQUEST (SIZE_MAX >> 16)
+
+// Arena shared by many threads: allocation is an atomic fetch-add on the bump offset of the
+// current block, and a full block is replaced by installing a new one with a single CAS.
+// There are no markers; memory is released all at once by reset() or the destructor.
+class ConcurrentArena {
+    private:
+        // Block header; the usable memory follows it, starting on its own cache line
+        struct Block {
+            Block *next;              // Block that was current before this one
+            uint8_t *base;            // Start of the usable memory
+            size_t capacity;          // Usable bytes
+            std::atomic<size_t> used; // Bytes handed out; overshoots capacity once the block is full
+        };
+
+        // Per-thread statistics counters, each on its own cache line and summed by stats(). Like
+        // Arena, requested bytes are derived (used minus padding and tails), so allocations only
+        // touch a shard when they skip bytes
+        struct alignas(64) Shard {
+            std::atomic<size_t> padding;    // Alignment padding skipped by live allocations
+            std::atomic<size_t> tail_waste; // Unused chunk ends left behind by thread-local buffers
+        };
+
+        std::atomic<Block*> current; // Block currently being bumped (newest in the chain)
+        std::atomic<uint64_t> epoch; // Bumped by reset() so buffers drop chunks carved before it
+        size_t initial_size;         // Capacity of the first block
+        Shard shards[ARENA_STAT_SHARDS];
+        std::atomic<size_t> tail_waste; // Unused ends of live blocks left behind by growth
+        std::atomic<size_t> growths;    // Blocks installed
+        std::atomic<size_t> mallocs;    // Blocks allocated (including ones that lost the install race)
+        std::atomic<size_t> peak;       // Highest usage seen so far
+
+        // This thread's counter shard
+        Shard& shard();
+
+        // Bytes consumed in the chain, block tails excluded
+        size_t used() const;
+
+        // Allocate a block header plus `capacity` usable bytes
+        static Block* new_block(size_t capacity);
+
+        // Slow path: `full` could not fit `bytes`, leaving `wasted` bytes unused at its end; install
+        // a larger block (or use the one another thread installed)
+        void* grow(Block* full, size_t bytes, size_t wasted);
+
+    public:
+        ConcurrentArena (size_t initial_size);
+
+        ConcurrentArena (const ConcurrentArena&) = delete;
+        ConcurrentArena& operator= (const ConcurrentArena&) = delete;
+
+        // Allocate memory aligned to ARENA_ALIGNMENT; safe to call from any number of threads
+        void* a_alloc(size_t bytes);
+
+        // Allocate memory aligned to `align` (any power of two); safe to call from any number of threads
+        void* a_alloc_aligned(size_t bytes, size_t align);
+
+        // Duplicate a string into the arena
+        char* strdup(const char* str);
+
+        // Release everything but the newest block; no other thread may be allocating meanwhile
+        void reset();
+
+        // Allocation statistics summed over all threads. Safe to call while others allocate (the
+        // result is then approximate). Thread-local buffers report when they refill or die; until
+        // then the unused rest of a live buffer's chunk counts as requested
+        ArenaStats stats();
+
+        ~ConcurrentArena();
+
+        friend class ArenaTlab;
+};
+
+// Thread-local allocation buffer: carves `chunk_size` chunks out of a shared ConcurrentArena and
+// bump-allocates from them privately, touching the shared arena only to refill. Each thread owns
+// its own buffer; everything it hands out lives until the parent is reset or destroyed.
+class ArenaTlab {
+    private:
+        ConcurrentArena *parent; // Shared arena the chunks come from
+        uint8_t *bump;           // Current allocation pointer in the chunk
+        uint8_t *end;            // End of the chunk
+        uint64_t epoch;          // Parent epoch the chunk belongs to
+        size_t chunk_size;       // Bytes taken from the parent per refill
+        size_t padding;          // Alignment padding skipped since the last flush
+
+        // Add the local padding count to this thread's shard of the parent, unless the parent was
+        // reset since (the padded allocations are gone then)
+        void flush();
+
+        // Slow path: grab a fresh chunk (or serve large requests straight from the parent)
+        void* refill(size_t bytes, size_t align);
+
+    public:
+        ArenaTlab (ConcurrentArena& parent, size_t chunk_size = ARENA_TLAB_CHUNK);
+
+        ArenaTlab (const ArenaTlab&) = delete;
+        ArenaTlab& operator= (const ArenaTlab&) = delete;
+
+        // Reports its counters and abandoned chunk end to the parent, which must still be alive
+        ~ArenaTlab();
+
+        // Allocate memory aligned to ARENA_ALIGNMENT; only the owning thread may call this
+        void* a_alloc(size_t bytes);
+
+        // Allocate memory aligned to `align` (any power of two)
+        void* a_alloc_aligned(size_t bytes, size_t align);
+
+        // Duplicate a string into the buffer
+        char* strdup(const char* str);
+};
+
+inline ConcurrentArena::Shard& ConcurrentArena::shard() {
+    static std::atomic<unsigned> next_index(0);
+    static thread_local unsigned index = next_index.fetch_add(1, std::memory_order_relaxed) % ARENA_STAT_SHARDS;
+    return this->shards[index];
+}
+
+// Allocate memory: reserve a slice of the current block with one fetch-add
+inline void* ConcurrentArena::a_alloc(size_t bytes) {
+    if (ARENA_UNLIKELY(bytes - 1 >= CONCURRENT_ARENA_MAX_REQUEST)) return NULL;  // Zero or too large
+    size_t rounded = (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (ARENA_UNLIKELY(rounded != bytes)) shard().padding.fetch_add(rounded - bytes, std::memory_order_relaxed);
+    Block* block = this->current.load(std::memory_order_acquire);
+    size_t offset = block->used.fetch_add(rounded, std::memory_order_relaxed);
+    if (ARENA_LIKELY(offset <= block->capacity && rounded <= block->capacity - offset)) {
+        return block->base + offset;
+    }
+    // Only the first slice to overshoot starts inside the block; it records the block's unused end
+    return grow(block, rounded, offset < block->capacity ? block->capacity - offset : 0);
+}
+
+// Allocate from the private chunk; the epoch check is a read of a line only reset() writes
+inline void* ArenaTlab::a_alloc(size_t bytes) {
+    if (ARENA_UNLIKELY(bytes == 0)) return NULL;
+    uint8_t* ptr = (uint8_t*)(((uintptr_t)this->bump + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1));
+    if (ARENA_LIKELY(ptr <= this->end && bytes <= (size_t)(this->end - ptr) &&
+                     this->epoch == this->parent->epoch.load(std::memory_order_relaxed))) {
+        if (ARENA_UNLIKELY(ptr != this->bump)) this->padding += (size_t)(ptr - this->bump);
+        this->bump = ptr + bytes;
+        return ptr;
+    }
+    return refill(bytes, ARENA_ALIGNMENT);
+}
+
+#endif // CONCURRENT_ARENA_H